@@ -113,6 +113,40 @@ void LoadLayout(const std::vector<Window*>& windows) {
             }
 }
 
+//--------------------------------------------------
+// Level Persistence
+//--------------------------------------------------
+// "width height", then one row per line with a digit per tile (TileType).
+// The engine reads this with TileMap::Load
+bool SaveLevel(const std::string& path) {
+    std::ofstream f(path, std::ios::trunc);
+    if (!f) return false;
+    f << GRID_SIZE << " " << GRID_SIZE << "\n";
+    for (int y = 0; y < GRID_SIZE; y++) {
+        for (int x = 0; x < GRID_SIZE; x++)
+            f << (int)grid[y * GRID_SIZE + x].type;
+        f << "\n";
+    }
+    return true;
+}
+
+bool LoadLevel(const std::string& path) {
+    std::ifstream f(path);
+    int w, h;
+    if (!(f >> w >> h) || w != GRID_SIZE || h != GRID_SIZE) return false;
+
+    std::vector<std::string> rows(GRID_SIZE);
+    for (auto& row : rows)
+        if (!(f >> row) || (int)row.size() != GRID_SIZE) return false;
+
+    for (int y = 0; y < GRID_SIZE; y++)
+        for (int x = 0; x < GRID_SIZE; x++) {
+            int type = rows[y][x] - '0';
+            grid[y * GRID_SIZE + x].type = (type >= EMPTY && type <= EXIT) ? (TileType)type : EMPTY;
+        }
+    return true;
+}
+
 //--------------------------------------------------
 // Init
 //--------------------------------------------------
@@ -290,7 +324,14 @@ void ExecuteConsoleCommand(const std::string& cmd) {
     historyIndex = (int)consoleHistory.size();
 
     if (cmd == "help") {
-        consoleLog.push_back("help, clear, run_engine");
+        consoleLog.push_back("help, clear, run_engine,");
+        consoleLog.push_back("save_level, load_level");
+    }
+    else if (cmd == "save_level") {
+        consoleLog.push_back(SaveLevel("level.txt") ? "Saved level.txt" : "Could not save level.txt");
+    }
+    else if (cmd == "load_level") {
+        consoleLog.push_back(LoadLevel("level.txt") ? "Loaded level.txt" : "Could not load level.txt");
     }
     else if (cmd == "clear") {
         consoleLog.clear();
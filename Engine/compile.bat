@@ -8,6 +8,9 @@ set "SRC_PATH=src"
 set "BUILD_PATH=build"
 set "LIB_PATH=lib"
 set "INCLUDE_PATH=include"
+:: Precise floating point without FMA contraction, see strictmath.h. GCC and
+:: Clang builds use -ffp-contract=off (and never -ffast-math) instead
+set "FP_FLAGS=/fp:precise"
 set "EXE_NAME=main.exe"
 
 :: Create build folder if it doesn't exist
@@ -29,7 +32,7 @@ if errorlevel 1 (
 echo Compiling...
 
 :: Put .obj files into build folder with /Fo
-cl /EHsc /MD /std:c++17 /I"%INCLUDE_PATH%" /Fo"%BUILD_PATH%\\" /Fe"%BUILD_PATH%\%EXE_NAME%" "%SRC_PATH%\*.cpp" /link /LIBPATH:"%LIB_PATH%" ^
+cl /EHsc /MD /std:c++17 %FP_FLAGS% /I"%INCLUDE_PATH%" /Fo"%BUILD_PATH%\\" /Fe"%BUILD_PATH%\%EXE_NAME%" "%SRC_PATH%\*.cpp" /link /LIBPATH:"%LIB_PATH%" ^
     raylib.lib ^
     opengl32.lib gdi32.lib user32.lib kernel32.lib winmm.lib shell32.lib advapi32.lib
 
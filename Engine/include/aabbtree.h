@@ -0,0 +1,152 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+
+// Closest box hit by AABBTree::Raycast
+struct TreeRayHit
+{
+    uint32_t userData = 0;
+    float distance = 0;
+    Vector2 point = {0, 0};
+    Vector2 normal = {0, 0}; // face of the box that was hit
+};
+
+// Dynamic bounding volume tree for spatial queries.
+// Leaves hold a tight box plus a fattened copy that the tree is built from,
+// so small moves only update the tight box and the tree is touched again
+// once an object leaves its fat box. Insertions pick the cheapest sibling
+// by perimeter and the tree is kept balanced with rotations on the way up.
+// Queries test the fat boxes while descending and the tight box at leaves.
+class AABBTree
+{
+public:
+    static const int32_t NULL_NODE = -1;
+
+    AABBTree();
+
+    // Returns the proxy handle, stable until DestroyProxy
+    int32_t CreateProxy(const Rectangle& box, uint32_t userData);
+    void DestroyProxy(int32_t proxy);
+    // displacement is the last move, the fat box is stretched along it.
+    // Returns true if the proxy was reinserted
+    bool MoveProxy(int32_t proxy, const Rectangle& box, Vector2 displacement);
+    void Clear();
+
+    uint32_t GetUserData(int32_t proxy) const;
+    int GetProxyCount() const;
+    int GetHeight() const;
+
+    // Appends the user data of every box overlapping box
+    void QueryBox(const Rectangle& box, std::vector<uint32_t>& results) const;
+    // Calls callback(userData) for every box overlapping box
+    template <typename Callback>
+    void Query(const Rectangle& box, Callback&& callback) const;
+    // Closest box along the ray within maxDistance, direction need not be normalized.
+    // Boxes containing the origin are not hit
+    bool Raycast(Vector2 origin, Vector2 direction, float maxDistance, TreeRayHit& hit, uint32_t ignore = UINT32_MAX) const;
+    // Box closest to point within maxDistance, 0 distance if inside
+    bool QueryNearest(Vector2 point, float maxDistance, uint32_t& userData, uint32_t ignore = UINT32_MAX) const;
+
+private:
+    struct Bounds
+    {
+        float minX, minY, maxX, maxY;
+    };
+
+    struct Node
+    {
+        Bounds fat;
+        Bounds tight;
+        uint32_t userData;
+        int32_t parent; // next free node while on the free list
+        int32_t child1;
+        int32_t child2;
+        int32_t height; // leaf = 0, free = -1
+
+        bool IsLeaf() const { return child1 == NULL_NODE; }
+    };
+
+    // Traversal stack for the queries. Lives on the call stack, so queries
+    // never allocate and can run on several threads at once. Walking a tree
+    // holds at most height + 1 nodes, far below the array for any balanced
+    // tree; anything past it spills to the heap
+    class NodeStack
+    {
+    public:
+        void Push(int32_t node)
+        {
+            if (count < LOCAL_SIZE)
+                local[count] = node;
+            else
+                spill.push_back(node);
+            ++count;
+        }
+
+        int32_t Pop()
+        {
+            --count;
+            if (count < LOCAL_SIZE)
+                return local[count];
+            const int32_t node = spill.back();
+            spill.pop_back();
+            return node;
+        }
+
+        bool IsEmpty() const { return count == 0; }
+
+    private:
+        static const int LOCAL_SIZE = 128;
+        int32_t local[LOCAL_SIZE];
+        int count = 0;
+        std::vector<int32_t> spill;
+    };
+
+    static Bounds ToBounds(const Rectangle& box);
+    static Bounds Combine(const Bounds& a, const Bounds& b);
+    static float Perimeter(const Bounds& b);
+    static bool Contains(const Bounds& outer, const Bounds& inner);
+    static bool Overlaps(const Bounds& a, const Bounds& b);
+    static float DistanceSquared(const Bounds& b, Vector2 point);
+    static Bounds Fatten(const Bounds& tight, Vector2 displacement);
+
+    int32_t AllocateNode();
+    void FreeNode(int32_t node);
+    void InsertLeaf(int32_t leaf);
+    void RemoveLeaf(int32_t leaf);
+    int32_t Balance(int32_t node);
+    void Refit(int32_t node);
+
+    std::vector<Node> nodes;
+    int32_t root;
+    int32_t freeList;
+    int proxyCount;
+};
+
+template <typename Callback>
+void AABBTree::Query(const Rectangle& box, Callback&& callback) const
+{
+    if (root == NULL_NODE)
+        return;
+
+    const Bounds query = ToBounds(box);
+    NodeStack stack;
+    stack.Push(root);
+    while (!stack.IsEmpty())
+    {
+        const Node& node = nodes[stack.Pop()];
+
+        if (!Overlaps(node.fat, query))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            if (Overlaps(node.tight, query))
+                callback(node.userData);
+            continue;
+        }
+
+        stack.Push(node.child1);
+        stack.Push(node.child2);
+    }
+}
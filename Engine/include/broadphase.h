@@ -0,0 +1,138 @@
+#pragma once
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include "entitystore.h"
+
+// Two rows whose bounds may overlap this tick, a < b.
+// Rows are only valid until the store's next Flush.
+struct CollisionPair
+{
+    uint32_t a;
+    uint32_t b;
+};
+
+// A pair that started or stopped overlapping since the previous Update
+struct PairEvent
+{
+    EntityId a;
+    EntityId b;
+};
+
+// Broadphase: cheaply finds the pairs worth handing to the narrowphase
+// (Physics::CheckCollision / ResolveCollision) instead of testing all N^2.
+// Entities are inserted with bounds covering their whole move this tick,
+// so bullets (ENTITY_BULLET) can be swept against every candidate.
+// ENTITY_NO_COLLISION entities are skipped and pairs whose collision
+// layers and masks don't accept each other are never reported.
+class Broadphase
+{
+public:
+    virtual ~Broadphase() = default;
+
+    // Bring the structure up to date with the store and rebuild the pair list
+    virtual void Update(const EntityStore& store) = 0;
+    const std::vector<CollisionPair>& GetPairs() const { return pairs; }
+
+    // Pair changes since the previous Update. Only broadphases that keep
+    // pairs between ticks (SweepAndPrune) fill these
+    const std::vector<PairEvent>& GetAddedPairs() const { return addedPairs; }
+    const std::vector<PairEvent>& GetRemovedPairs() const { return removedPairs; }
+
+protected:
+    std::vector<CollisionPair> pairs;
+    std::vector<PairEvent> addedPairs;
+    std::vector<PairEvent> removedPairs;
+};
+
+// Uniform grid hashed into a fixed table of buckets, rebuilt every tick.
+// Each entity is inserted into every cell its bounds touch; two entities
+// sharing a cell become a candidate pair. A pair that shares several cells
+// is only reported from the cell holding the top-left corner of the overlap.
+// Entities spanning more than MAX_CELLS_PER_AXIS cells on an axis aren't
+// put in the grid, they are tested against every other entity instead.
+class SpatialHashGrid : public Broadphase
+{
+public:
+    explicit SpatialHashGrid(float cellSize = 64.0f);
+
+    void Update(const EntityStore& store) override;
+
+    void SetCellSize(float size);
+    float GetCellSize() const;
+
+private:
+    struct Entry
+    {
+        int32_t cellX;
+        int32_t cellY;
+        uint32_t row;
+        float minX; // top-left of the row's bounds
+        float minY;
+    };
+
+    uint32_t Bucket(int32_t cellX, int32_t cellY) const;
+    int32_t CellOf(float coordinate) const;
+    void AddOversizedPairs(const EntityStore& store);
+
+    float cellSize;
+    float inverseCellSize;
+    uint32_t bucketMask = 0;
+
+    // Scratch kept between ticks so rebuilding doesn't allocate
+    std::vector<Entry> entries;
+    std::vector<Entry> sorted;
+    std::vector<uint32_t> bucketStart;
+    std::vector<uint32_t> oversized; // rows left out of the grid
+    std::vector<uint8_t> isOversized; // per row, while oversized isn't empty
+};
+
+// Incremental sweep-and-prune over both axes.
+// Box endpoints stay sorted between ticks and are re-sorted with insertion
+// sort, which is close to linear when things move a little each tick. Every
+// swap of a min past a max (or back) is an overlap starting or ending on that
+// axis, so the pair set is kept up to date from the swaps alone and the
+// changes come out as pair-added / pair-removed events. Large batches of new
+// entities fall back to a full sort and sweep. A layer or mask change only
+// affects overlaps that start after it.
+class SweepAndPrune : public Broadphase
+{
+public:
+    void Update(const EntityStore& store) override;
+
+private:
+    struct Proxy
+    {
+        EntityId id;
+        bool active = false;
+        bool seen = false;
+        bool replaced = false; // slot reused this tick, see RemoveStaleProxies
+        EntityId replacedId; // the entity that had it before
+        uint32_t row = 0;
+        uint32_t layer = 0;
+        uint32_t mask = 0;
+        float min[2] = {0, 0};
+        float max[2] = {0, 0};
+    };
+
+    struct Endpoint
+    {
+        float value;
+        uint32_t proxy;
+        bool isMax;
+    };
+
+    static uint64_t PairKey(uint32_t a, uint32_t b);
+    bool Overlaps(uint32_t a, uint32_t b) const;
+    void AddPair(uint32_t a, uint32_t b);
+    void RemovePair(uint32_t a, uint32_t b);
+
+    void RemoveStaleProxies();
+    void SortAxis(int axis);
+    void Rebuild();
+
+    std::vector<Proxy> proxies; // indexed by EntityId slot
+    std::vector<Endpoint> axes[2];
+    std::unordered_set<uint64_t> pairSet;
+    std::vector<uint32_t> added; // proxies new this tick
+};
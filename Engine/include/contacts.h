@@ -0,0 +1,101 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "broadphase.h"
+#include "entitystore.h"
+
+// Persistent contacts and a sequential impulse solver.
+//
+// Every touching pair gets a contact normal (the axis of least penetration
+// between the two boxes) and an accumulated normal impulse. Contacts are
+// cached by entity pair across steps: a pair still touching along the same
+// normal starts from the last step's impulse (warm starting), so resting and
+// pressed bodies converge in a few iterations instead of rebuilding the
+// impulse from zero each tick and jittering. Each iteration applies the
+// impulse change of every contact in turn, clamped so the total never pulls
+// bodies together. Restitution adds a bounce for fast impacts. Remaining
+// overlap is then pushed out by moving positions directly, so correcting
+// it never adds velocity.
+//
+// Sleeping, static and zero-mass bodies don't move. Bullet impacts are only
+// reported (see Narrowphase), not solved.
+//
+// Constraints are greedily graph colored so no two of one color share a
+// movable body. Colors are solved one after another and the constraints of
+// a color in parallel on the JobSystem; since they touch disjoint bodies
+// the result is the same for any number of threads. The solver doesn't use
+// IslandManager's islands: those are built after the solve, over rows the
+// next Flush renumbers, and are only used for sleeping.
+class ContactManager
+{
+public:
+    void SetIterations(int count);
+    int GetIterations() const;
+    // Solve in entity handle order rather than the broadphase's pair order,
+    // so results only depend on which entities touch
+    void SetDeterministic(bool enabled);
+
+    // Solve the velocities of the overlapping rows. Call once per step,
+    // every substep when Game::Update substeps. Impulses are velocity
+    // changes and overlap is removed by moving positions, so nothing here
+    // depends on the step length
+    void Update(EntityStore& store, const std::vector<CollisionPair>& overlaps);
+
+    size_t GetContactCount() const;
+    // Colors used in the last Update
+    size_t GetColorCount() const;
+
+private:
+    // One bit per color in a body's color mask. Constraints that find all
+    // of them taken go to one extra batch solved on a single thread
+    static const uint32_t MAX_COLORS = 64;
+
+    struct CachedContact
+    {
+        EntityId a;
+        EntityId b;
+        float normalX;
+        float normalY;
+        float impulse;
+        uint32_t tick; // last Update the pair touched
+    };
+
+    struct Constraint
+    {
+        uint32_t a;
+        uint32_t b;
+        float normalX; // from a to b
+        float normalY;
+        float normalMass; // 1 / (inverse mass a + inverse mass b)
+        float bias; // target separating speed
+        float impulse; // accumulated, >= 0
+        uint64_t key; // cache key, handle slots of both bodies
+        CachedContact* cached;
+    };
+
+    void AssignColors(size_t rows);
+    template <typename Function>
+    void ForEachColor(const Function& function);
+
+    void ApplyImpulse(EntityStore& store, const Constraint& constraint, float impulse);
+    void WarmStart(EntityStore& store, Constraint& constraint);
+    void SolveVelocity(EntityStore& store, Constraint& constraint);
+    void SolvePosition(EntityStore& store, Constraint& constraint);
+
+    int iterations = 4;
+    bool deterministic = false;
+    uint32_t tick = 0;
+
+    std::unordered_map<uint64_t, CachedContact> cache; // by handle slot pair
+    std::vector<Constraint> constraints;
+    std::vector<float> inverseMasses; // per row scratch
+
+    // Coloring scratch. Constraints of color c are
+    // constraints[colorOffsets[c] .. colorOffsets[c + 1])
+    std::vector<uint64_t> bodyColors;
+    std::vector<uint32_t> colorOf;
+    std::vector<uint32_t> colorOffsets;
+    std::vector<uint32_t> colorCursor;
+    std::vector<Constraint> colored;
+};
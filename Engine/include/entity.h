@@ -1,18 +1,43 @@
 #pragma once
+#include <cstddef>
+#include <cstdint>
 #include "raylib.h"
 
+class EntityStore;
+class Renderer;
+struct EntityId;
+
+// Lightweight view onto one row of an EntityStore.
+// The component data lives in the store's columns; a view is just
+// the store and a row index, so it is cheap to copy and pass around.
+// Views are invalidated by EntityStore::Flush, which compacts the rows,
+// so keep an EntityId across frames and ask Game::GetEntity for a fresh view.
 class Entity
 {
 public:
-    Vector3 position;
-    Vector3 velocity;
-    Vector3 size;
-    float friction = 1;
-    Color color;
+    Entity(EntityStore* store, size_t index);
+
+    Vector3& Position() const;
+    Vector3& Velocity() const;
+    Vector3& Size() const;
+    float& Friction() const;
+    float& Mass() const;
+    float& Restitution() const;
+    Color& Tint() const;
+    uint32_t& Tags() const;
+
+    // False for a view of a stale or not yet flushed handle, see
+    // Game::GetEntity. Nothing else may be called on an invalid view
+    bool IsValid() const;
+    size_t GetIndex() const;
+    EntityId GetId() const;
 
-    Entity(Vector3 startPos, Vector3 startSize, Color startColor);
+    void Draw(Renderer& renderer) const;
+    // Wakes the entity unless the force is zero
+    void AddForce(Vector3 force) const;
+    void Wake() const;
 
-    void Update(float deltaTime);
-    void Draw() const;
-    void AddForce(Vector3 force);
+private:
+    EntityStore* store;
+    size_t index;
 };
@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include "entity.h"
+#include "entitystore.h"
+
+// Non-owning range over the rows of an EntityStore.
+// Iterating yields Entity views straight off the columns, so walking every
+// entity costs no allocation or copy. Filters narrow the rows by tag; rows
+// destroyed since the last flush are always skipped.
+//
+//     for (Entity e : game.GetEntities().WithTags(TAG_ENEMY)) ...
+//
+// Like Entity views, a range is invalidated by the store's next Flush.
+class EntityRange
+{
+public:
+    class Iterator
+    {
+    public:
+        Iterator(const EntityRange* range, size_t index) : range(range), index(index) { Skip(); }
+
+        Entity operator*() const { return Entity(range->store, index); }
+        Iterator& operator++() { ++index; Skip(); return *this; }
+        bool operator!=(const Iterator& other) const { return index != other.index; }
+        bool operator==(const Iterator& other) const { return index == other.index; }
+
+    private:
+        void Skip()
+        {
+            const size_t count = range->store->Count();
+            while (index < count && !range->Matches(index))
+                ++index;
+        }
+
+        const EntityRange* range;
+        size_t index;
+    };
+
+    explicit EntityRange(EntityStore* store) : store(store) {}
+
+    // Only rows that have every bit in mask
+    EntityRange WithTags(uint32_t mask) const
+    {
+        EntityRange range = *this;
+        range.required |= mask;
+        return range;
+    }
+
+    // Only rows that have none of the bits in mask
+    EntityRange WithoutTags(uint32_t mask) const
+    {
+        EntityRange range = *this;
+        range.excluded |= mask;
+        return range;
+    }
+
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, store->Count()); }
+
+    bool Matches(size_t index) const
+    {
+        const uint32_t tags = store->tags[index];
+        return (tags & required) == required && (tags & excluded) == 0 && store->IsRowAlive(index);
+    }
+
+    // Number of matching rows, walks the range
+    size_t Count() const
+    {
+        size_t count = 0;
+        for (auto it = begin(); it != end(); ++it)
+            ++count;
+        return count;
+    }
+
+private:
+    EntityStore* store;
+    uint32_t required = 0;
+    uint32_t excluded = 0;
+};
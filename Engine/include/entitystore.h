@@ -0,0 +1,209 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "raylib.h"
+
+// Generational handle to an entity.
+// The index picks a slot in the store's sparse table and the generation
+// must match the slot's current generation, so a handle to a removed
+// entity is detected instead of silently aliasing whatever reused the slot.
+struct EntityId
+{
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool operator==(const EntityId& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const EntityId& other) const { return !(*this == other); }
+};
+
+// Engine-defined behaviour bits, see EntityDesc::flags
+enum EntityFlags : uint32_t
+{
+    // Fast mover: collision is swept along the whole tick's motion and stops
+    // at the first thing hit, so it can't pass through thin targets
+    ENTITY_BULLET = 1 << 0,
+    // Never collides: kept out of the broadphase entirely (decoration)
+    ENTITY_NO_COLLISION = 1 << 1,
+    // Never moves: not integrated, never sleeps or wakes, and doesn't link
+    // the bodies touching it into one island (level geometry)
+    ENTITY_STATIC = 1 << 2,
+    // Sensor: overlaps are reported as enter/exit events (Game::GetTriggerEvents)
+    // but never pushed apart, bullets and walls don't stop at it
+    ENTITY_TRIGGER = 1 << 3,
+};
+
+// Initial component values for a new entity
+struct EntityDesc
+{
+    Vector3 position = {0, 0, 0};
+    Vector3 size = {1, 1, 1};
+    Color color = WHITE;
+    Vector3 velocity = {0, 0, 0};
+    float friction = 1; // fraction of velocity kept per 1/60 s
+    float mass = 1; // 0 = immovable
+    float restitution = 0; // bounciness of contacts, 0..1
+    uint8_t pool = 0; // see EntityStore::CreatePool
+    uint32_t tags = 0; // game-defined bits, used to filter EntityRange
+    uint32_t flags = 0; // EntityFlags
+    // Two entities collide only if each one's layer is in the other's mask
+    uint32_t collisionLayer = 1;
+    uint32_t collisionMask = UINT32_MAX;
+};
+
+// Result of EntityStore::PlanSubsteps
+struct SubstepPlan
+{
+    uint32_t count = 1; // substeps this tick, the most any row needs
+    uint32_t substeppedRows = 0; // rows taking more than one step
+    uint32_t rowSteps = 0; // integration steps over all active rows
+};
+
+// Structure-of-arrays storage for every entity in the game.
+// Each component lives in its own contiguous column so the per-frame
+// passes (integration, drawing, bounds checks) stream linearly through memory
+// instead of pointer-chasing individually allocated objects.
+//
+// Spawning and destroying are deferred: Spawn reserves a handle and queues
+// the row, Destroy only marks the row dead. Flush then compacts the columns
+// in one linear pass and appends the queued rows, so nothing reallocates or
+// shifts while a pass is iterating. Row indices are only stable between
+// flushes; hold an EntityId across frames and resolve it with IndexOf.
+//
+// Handle slots are grouped into pools. Pool 0 is the default and grows on
+// demand; pools made with CreatePool own a fixed slab of slots with their own
+// free list and reserve matching column capacity up front, so spawning and
+// destroying inside a pool's budget never touches the heap.
+//
+// Spawn may be called from several threads at once, and alongside Destroy
+// and handle lookups, so systems running in parallel can spawn. New pool 0
+// slots are only added to the table by Flush, so lookups never see it move.
+// Destroy must not run alongside lookups (COMPONENT_ENTITIES write).
+class EntityStore
+{
+public:
+    EntityStore();
+
+    // Pool ids are stored in a byte per slot, the last value means none
+    static const uint8_t INVALID_POOL = UINT8_MAX;
+    static const size_t MAX_POOLS = INVALID_POOL; // including pool 0
+
+    // Fixed-capacity pool, returns the id to put in EntityDesc::pool, or
+    // INVALID_POOL once MAX_POOLS exist
+    uint8_t CreatePool(uint32_t capacity);
+    // Slots still available in a pool (pool 0 always has room, unknown
+    // pools have none)
+    uint32_t FreeInPool(uint8_t pool) const;
+
+    // Reserve a handle now, the row is added on the next Flush.
+    // Returns an invalid handle if the requested pool is full or unknown
+    EntityId Spawn(const EntityDesc& desc);
+    // Mark for removal on the next Flush. Returns false for stale handles
+    bool Destroy(EntityId id);
+    void DestroyAt(size_t index);
+    // Drop dead rows and append pending spawns
+    void Flush();
+    void Clear();
+
+    // False once destroyed, even before the row is compacted away
+    bool IsAlive(EntityId id) const;
+    // Returned by IndexOf for handles without a row
+    static const size_t INVALID_INDEX = SIZE_MAX;
+
+    // Row index of a live, flushed handle. INVALID_INDEX for stale handles
+    // and spawns still waiting for the next Flush
+    size_t IndexOf(EntityId id) const;
+
+    size_t Count() const;
+    // False for rows destroyed since the last Flush
+    bool IsRowAlive(size_t index) const;
+
+    // Integrate every row: position += velocity * dt, then apply friction.
+    // Friction is scaled by dt so it behaves the same at any frame rate.
+    // Runs the batch kernel from integrator.h in parallel chunks
+    void Integrate(float dt);
+
+    // Steps each row needs this tick to move at most half its smallest side
+    // per step, a power of two up to maxSubsteps. Only rows that get pushed
+    // by contacts are planned: bullets are swept instead, and triggers,
+    // ENTITY_NO_COLLISION and inactive rows take one step
+    SubstepPlan PlanSubsteps(float dt, uint32_t maxSubsteps);
+    // Substep substep of plan.count of a dt long tick. A row planned for k
+    // steps moves by dt / k on every (count / k)th substep, starting with
+    // the first, so every row has covered dt once all substeps have run
+    void IntegrateSubstep(float dt, uint32_t substep, uint32_t count);
+
+    // Copy positions into previousPositions, called before a simulation tick
+    void SavePreviousPositions();
+
+    // Sleeping rows keep zero velocity and are skipped by Integrate until
+    // woken, see IslandManager
+    void Sleep(size_t index);
+    void Wake(size_t index);
+    // Awake and not ENTITY_STATIC
+    bool IsRowActive(size_t index) const;
+
+    // 64-bit hash of the simulation state of every row in row order:
+    // handles, positions, velocities, sizes, rest times, flags and sleep
+    // state. Equal hashes on two machines mean they are still in lockstep
+    uint64_t ComputeHash() const;
+
+    // Component columns, all the same length
+    std::vector<Vector3> positions;
+    std::vector<Vector3> previousPositions; // start of the last tick, for interpolation
+    std::vector<Vector3> velocities;
+    std::vector<Vector3> sizes;
+    std::vector<float> frictions;
+    std::vector<float> masses;
+    std::vector<float> restitutions;
+    std::vector<Color> colors;
+    std::vector<uint32_t> tags;
+    std::vector<uint32_t> flags; // EntityFlags
+    std::vector<uint32_t> collisionLayers;
+    std::vector<uint32_t> collisionMasks;
+    std::vector<float> restTimes; // seconds spent nearly still
+    std::vector<uint8_t> sleeping;
+    std::vector<EntityId> ids; // handle of each row
+
+private:
+    struct Slot
+    {
+        uint32_t row;
+        uint32_t generation;
+        uint8_t pool;
+    };
+
+    struct Pool
+    {
+        uint32_t capacity; // 0 = grows on demand
+        std::vector<uint32_t> freeSlots;
+    };
+
+    struct PendingSpawn
+    {
+        EntityId id;
+        EntityDesc desc;
+    };
+
+    std::vector<Slot> slots;
+    std::vector<Pool> pools;
+
+    void ReleaseSlot(uint32_t slot);
+    void AddNewSlots();
+    void IntegrateRange(size_t begin, size_t end, float dt, uint32_t substep, uint32_t count);
+    void ReserveRows(size_t count);
+
+    std::vector<uint8_t> dead; // per row, set by Destroy until the next Flush
+    size_t deadCount = 0;
+    std::vector<PendingSpawn> pendingSpawns;
+
+    // Guards pools' free lists, pendingSpawns and newSlots
+    mutable std::mutex spawnMutex;
+    // Pool 0 slots past the end of slots handed out since the last Flush,
+    // 1 if the pending entity was destroyed again
+    std::vector<uint8_t> newSlots;
+
+    std::vector<float> damping; // per-row scratch for Integrate
+    std::vector<uint8_t> substeps; // per-row steps from PlanSubsteps, valid until the next Flush
+};
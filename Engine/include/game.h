@@ -1,7 +1,55 @@
 #pragma once
+#include <memory>
 #include <vector>
+#include "aabbtree.h"
+#include "broadphase.h"
+#include "contacts.h"
 #include "entity.h"
+#include "entityrange.h"
+#include "entitystore.h"
+#include "islands.h"
+#include "narrowphase.h"
+#include "particles.h"
+#include "renderer.h"
 #include "settings.h"
+#include "systems.h"
+#include "tilemap.h"
+#include "triggers.h"
+
+// Two entities that overlapped during the last Update
+struct Collision
+{
+    EntityId a;
+    EntityId b;
+};
+
+// Closest entity hit by Game::Raycast
+struct RaycastHit
+{
+    EntityId entity;
+    float distance = 0;
+    Vector2 point = {0, 0};
+    Vector2 normal = {0, 0};
+};
+
+// Entity stopped by a wall of the tile map during the last Update
+struct TileCollision
+{
+    EntityId entity;
+    int x, y; // tile
+    Rectangle wall; // merged wall the tile is part of, see TileMap::Bake
+    Vector2 normal; // out of the wall
+};
+
+// What the last Update did, for profiling overlays
+struct PhysicsStats
+{
+    uint32_t substeps = 1; // see EntityStore::PlanSubsteps
+    uint32_t substeppedBodies = 0; // bodies that took more than one step
+    uint32_t bodySteps = 0; // integration steps over all active bodies
+    size_t contacts = 0; // solved in the last substep
+    size_t islands = 0;
+};
 
 class Game 
 {
@@ -10,15 +58,114 @@ public:
     Game(Settings& settings);  
     ~Game();
 
+    // Advance the simulation by one fixed tick: integrate, detect and solve
+    // contacts, then run the registered systems, then apply their spawns
+    // and removals
     void Update(float dt);
-    void Draw();
+    // alpha blends between the previous and current tick (see FixedTimestep).
+    // Only issues draw calls, the frame is begun and ended by the caller
+    void Draw(float alpha = 1.0f);
 
-    void SpawnEntity(Entity* entity);
-    void RemoveEntity(Entity* entity);
+    // Where Draw goes. A RaylibRenderer, or a NullRenderer over a
+    // windowWidth x windowHeight viewport when video.headless is set
+    Renderer& GetRenderer();
+    void SetRenderer(std::unique_ptr<Renderer> renderer);
+    // Visible area in world units, from the renderer. Use this instead of
+    // GetScreenWidth/Height, which need a window
+    Vector2 GetViewportSize() const;
 
-    std::vector<Entity*> GetEntities() const;
+    // Gameplay system run every Update, see SystemScheduler
+    void RegisterSystem(const std::string& name, uint32_t reads, uint32_t writes, SystemScheduler::SystemFunction function);
+    void PrintSystemSchedule();
+
+    // Fixed-capacity entity pool, see EntityStore::CreatePool.
+    // Spawning into a full pool returns an invalid EntityId, past
+    // EntityStore::MAX_POOLS this returns EntityStore::INVALID_POOL
+    uint8_t CreateEntityPool(uint32_t capacity);
+
+    // Spawns and removals are queued and applied by Update, never
+    // in the middle of a pass over the entities. Systems may spawn from
+    // several threads at once
+    EntityId SpawnEntity(const EntityDesc& desc);
+    // Stale handles are ignored
+    void RemoveEntity(EntityId id);
+
+    bool IsAlive(EntityId id) const;
+    // View onto a live entity that has been through an Update,
+    // valid until the end of the next Update. Stale handles, and ones
+    // spawned since the last Update, give an invalid view (Entity::IsValid)
+    Entity GetEntity(EntityId id);
+
+    ParticleSystem& GetParticles();
+
+    // Overlapping pairs found by the broadphase + narrowphase this tick.
+    // Bullets (ENTITY_BULLET) report the first thing they hit along their
+    // move and are stopped there. Triggers are not in here, see GetTriggerEvents
+    const std::vector<Collision>& GetCollisions() const;
+
+    // Enter/exit events of trigger entities (ENTITY_TRIGGER) this tick
+    const std::vector<TriggerEvent>& GetTriggerEvents() const;
+    // other has overlapped trigger since it entered, no test is done here
+    bool IsInTrigger(EntityId trigger, EntityId other) const;
+
+    // Level walls, entities are kept out of them every Update
+    TileMap& GetTileMap();
+    const std::vector<TileCollision>& GetTileCollisions() const;
+
+    const PhysicsStats& GetPhysicsStats() const;
+    // Ticks simulated so far
+    uint32_t GetTick() const;
+    // EntityStore::ComputeHash at the end of the last Update, only kept up
+    // when simulation.deterministic is set (0 otherwise). Compare it between
+    // lockstep peers or against a recorded replay to catch divergence
+    uint64_t GetStateHash() const;
+
+    // Every live entity, without copying. Filter with WithTags/WithoutTags
+    EntityRange GetEntities();
+
+    // Spatial queries against entity bounds, answered by a dynamic AABB tree.
+    // Bounds are as of collision detection this tick, before systems run.
+    // Fills results with every entity overlapping box
+    void QueryBox(const Rectangle& box, std::vector<EntityId>& results) const;
+    // First entity along the ray, ignoring one (usually the caster)
+    bool Raycast(Vector2 origin, Vector2 direction, float maxDistance, RaycastHit& hit, EntityId ignore = EntityId()) const;
+    // Closest entity to point, invalid EntityId if none within maxDistance
+    EntityId QueryNearest(Vector2 point, float maxDistance, EntityId ignore = EntityId()) const;
 
 private:
-    std::vector<Entity*> entities;
+    // Tree leaf of the entity in each handle slot
+    struct SpatialProxy
+    {
+        EntityId id;
+        int32_t proxy = AABBTree::NULL_NODE;
+        uint32_t lastTick = 0;
+    };
+
+    void CullOffscreen();
+    void DetectCollisions();
+    void RemoveDuplicateCollisions();
+    void CollideWithTiles();
+    void UpdateSpatialIndex();
+
+    EntityStore entities; // component columns, see entitystore.h
+    SystemScheduler systems;
+    ParticleSystem particles;
+    std::unique_ptr<Renderer> renderer;
+    std::unique_ptr<Broadphase> broadphase;
+    Narrowphase narrowphase;
+    ContactManager contactManager;
+    IslandManager islands;
+    TriggerTracker triggers;
+    std::vector<CollisionPair> contacts; // rows touching this tick, for islands
+    std::vector<CollisionPair> triggerOverlaps; // of every substep, for triggers
+    std::vector<Collision> collisions;
+    TileMap tilemap;
+    std::vector<TileCollision> tileCollisions;
+    AABBTree spatialIndex;
+    std::vector<SpatialProxy> spatialProxies;
+    uint32_t tick = 0;
+    uint64_t stateHash = 0;
+    PhysicsStats stats;
+    std::vector<Vector3> tickStart; // positions at the start of a substepped tick
     Settings* settings; // store pointer instead of copy
 };
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+
+// Batch motion integration over the EntityStore columns.
+//
+// For every entity i:
+//     position += velocity * dt
+//     velocity *= damping[i]
+//
+// positions and velocities are packed xyz triples (the Vector3 columns viewed
+// as floats), damping holds one factor per entity. SSE2 and AVX2 kernels are
+// picked at runtime from what the CPU supports. Every path does a separate
+// multiply and add per component (no FMA), so all of them produce the same
+// bits as the scalar loop.
+namespace Integrator
+{
+    enum class Path
+    {
+        Scalar,
+        SSE2,
+        AVX2
+    };
+
+    // Best path the CPU supports
+    Path DetectPath();
+    // Path used by IntegrateBatch, defaults to DetectPath()
+    Path GetPath();
+    // Force a path, e.g. Scalar for deterministic runs. Unsupported paths
+    // fall back to the best supported one
+    void SetPath(Path path);
+    const char* GetPathName(Path path);
+
+    void IntegrateBatch(float* positions, float* velocities, const float* damping, size_t count, float dt);
+
+    // Kernels, exposed so the paths can be compared against each other
+    void IntegrateScalar(float* positions, float* velocities, const float* damping, size_t count, float dt);
+    void IntegrateSSE2(float* positions, float* velocities, const float* damping, size_t count, float dt);
+    void IntegrateAVX2(float* positions, float* velocities, const float* damping, size_t count, float dt);
+}
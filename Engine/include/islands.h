@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "broadphase.h"
+#include "entitystore.h"
+
+// Rest detection and simulation islands.
+// Every tick the bodies touching each other (this tick's contacts) are
+// joined into islands with a union-find. Static bodies never join, so a
+// floor doesn't link everything standing on it. A body that has moved
+// slower than a small threshold for sleepTime seconds is at rest; an island
+// sleeps as a whole once all its bodies are at rest, and wakes as a whole
+// when any of them moves or something awake touches it.
+//
+// Sleeping bodies are skipped by EntityStore::Integrate and pairs of
+// sleeping or static bodies are skipped by the narrowphase. Waking spreads
+// one contact per tick through bodies that are all asleep. Islands are only
+// used for sleeping, the contact solver splits its work by graph coloring
+// instead (see ContactManager).
+class IslandManager
+{
+public:
+    // Seconds at rest before sleeping, 0 disables sleeping
+    void SetSleepTime(float seconds);
+    float GetSleepTime() const;
+
+    // contacts are rows touching this tick (narrowphase output)
+    void Update(EntityStore& store, const std::vector<CollisionPair>& contacts, float dt);
+
+    // Islands from the last Update. The rows of island i are
+    // GetBodies()[GetOffsets()[i] .. GetOffsets()[i + 1]).
+    // Sleeping bodies nothing touched this tick are in no island
+    size_t GetIslandCount() const;
+    const std::vector<uint32_t>& GetOffsets() const { return offsets; }
+    const std::vector<uint32_t>& GetBodies() const { return bodies; }
+
+private:
+    uint32_t Find(uint32_t row);
+    void Union(uint32_t a, uint32_t b);
+
+    float sleepTime = 0.5f;
+
+    // Scratch per row, rebuilt every Update
+    std::vector<uint32_t> parent;
+    std::vector<uint8_t> touched;
+    std::vector<float> islandRest; // per root
+    std::vector<uint32_t> rootIsland; // per root
+    std::vector<uint32_t> islandIndex; // root, then island, per body
+
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> bodies;
+};
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+struct JobCounter;
+
+// One unit of work: a plain function over an index range.
+// Jobs are small PODs so queueing them never allocates.
+struct Job
+{
+    void (*function)(void* data, size_t begin, size_t end) = nullptr;
+    void* data = nullptr;
+    size_t begin = 0;
+    size_t end = 0;
+    JobCounter* counter = nullptr; // decremented when the job finishes
+};
+
+// Counts unfinished jobs. Wait on it to join them, or pass it as the
+// dependency of a later Run so that job only starts once this hits zero.
+struct JobCounter
+{
+    std::atomic<int> pending{0};
+
+    bool IsDone() const { return pending.load() == 0; }
+
+private:
+    friend class JobSystem;
+    std::mutex lock;
+    std::vector<Job> continuations; // jobs waiting for this counter
+};
+
+// Work-stealing job scheduler.
+// Every worker owns a deque: it pushes and pops its own jobs at the back
+// and, when empty, steals the oldest job from the front of another deque.
+// The calling (main) thread has a deque too and runs jobs while it waits.
+class JobSystem
+{
+public:
+    // Lifecycle. workerCount 0 = one worker per core, minus the main thread
+    static void Init(int workerCount = 0);
+    static void Shutdown();
+
+    static int GetWorkerCount();
+
+    // Queue a job. If after is given and not done yet, the job is held
+    // back until it is. Without workers, jobs run inline
+    static void Run(const Job& job, JobCounter* after = nullptr);
+
+    // Block until counter is done, running queued jobs meanwhile
+    static void Wait(JobCounter& counter);
+
+    // Split [0, count) into chunks of at least minChunk and run body(begin, end)
+    // on each, returning once all chunks are done
+    template <typename Body>
+    static void ParallelFor(size_t count, size_t minChunk, const Body& body)
+    {
+        if (count == 0)
+            return;
+
+        // Aim for a few chunks per thread so stealing can even out the load
+        const size_t threads = (size_t)GetWorkerCount() + 1;
+        size_t chunk = count / (threads * 4);
+        if (chunk < minChunk) chunk = minChunk;
+        if (chunk == 0) chunk = 1;
+
+        if (threads == 1 || chunk >= count)
+        {
+            body((size_t)0, count);
+            return;
+        }
+
+        JobCounter counter;
+        for (size_t begin = 0; begin < count; begin += chunk)
+        {
+            Job job;
+            job.function = &InvokeRange<Body>;
+            job.data = (void*)&body;
+            job.begin = begin;
+            job.end = begin + chunk < count ? begin + chunk : count;
+            job.counter = &counter;
+            Run(job);
+        }
+        Wait(counter);
+    }
+
+private:
+    struct WorkQueue;
+
+    template <typename Body>
+    static void InvokeRange(void* data, size_t begin, size_t end)
+    {
+        (*(const Body*)data)(begin, end);
+    }
+
+    static void WorkerLoop(int index);
+    static bool TryGetJob(int index, Job& job);
+    static void Execute(const Job& job);
+    static void Push(const Job& job);
+
+    static std::vector<std::unique_ptr<WorkQueue>> queues; // [0] = main thread
+    static std::vector<std::thread> workers;
+    static std::atomic<bool> running;
+    static std::atomic<int> queuedJobs;
+    static std::mutex sleepLock;
+    static std::condition_variable wakeUp;
+};
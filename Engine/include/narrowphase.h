@@ -0,0 +1,83 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "broadphase.h"
+#include "entitystore.h"
+
+// Batched box overlap tests for the narrowphase.
+//
+// Bounds are SoA min/max columns indexed by row. One box is tested against
+// a list of other rows 4 (SSE2) or 8 (AVX2) at a time and hits[i] is set to
+// 1 or 0 for others[i]. The comparisons are the ones CheckCollisionRecs
+// makes, with max = position + size computed the same way, so every path
+// agrees with Physics::CheckCollision bit for bit. The path follows
+// Integrator::GetPath, so deterministic runs pin this to scalar as well.
+namespace Overlap
+{
+    void TestBatch(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                   uint32_t box, const uint32_t* others, size_t count, uint8_t* hits);
+
+    // Kernels, exposed so the paths can be compared against each other
+    void TestScalar(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                    uint32_t box, const uint32_t* others, size_t count, uint8_t* hits);
+    void TestSSE2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                  uint32_t box, const uint32_t* others, size_t count, uint8_t* hits);
+    void TestAVX2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                  uint32_t box, const uint32_t* others, size_t count, uint8_t* hits);
+}
+
+// First thing a bullet hit along its move this tick
+struct Impact
+{
+    uint32_t bullet; // row
+    uint32_t other;  // row
+    float time;      // fraction of the tick, see Physics::SweepTest
+};
+
+// Confirms broadphase candidate pairs with Overlap::TestBatch.
+// Candidates are grouped by their first row so each box is loaded once and
+// tested against all of its partners in one batch. Pairs with a bullet in
+// them are swept instead, keeping only each bullet's earliest hit. Pairs
+// where neither body is active (asleep or ENTITY_STATIC) are skipped, except
+// with a trigger, which are kept apart from the rest.
+class Narrowphase
+{
+public:
+    // Sort each row's partners so overlaps come out in row order whatever
+    // order the broadphase found them in
+    void SetDeterministic(bool enabled);
+
+    void Update(const EntityStore& store, const std::vector<CollisionPair>& candidates);
+
+    // Candidates without bullets that really overlap, grouped by a in row order
+    const std::vector<CollisionPair>& GetOverlaps() const { return overlaps; }
+    // Trigger (ENTITY_TRIGGER) overlapping a non-trigger, as (trigger, other).
+    // Tested at the final positions, bullets included
+    const std::vector<CollisionPair>& GetTriggerOverlaps() const { return triggerOverlaps; }
+    // One per bullet that hit something. Two bullets hitting each other
+    // first are reported once
+    const std::vector<Impact>& GetImpacts() const { return impacts; }
+
+private:
+    bool deterministic = false;
+
+    // Row bounds, rebuilt every Update
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+
+    // Candidates bucketed by a: partners of row r are
+    // partners[offsets[r] .. offsets[r + 1])
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> partners;
+    std::vector<uint8_t> hits;
+
+    // Earliest hit per bullet row so far, time > 1 = none
+    std::vector<Impact> earliest;
+
+    std::vector<CollisionPair> overlaps;
+    std::vector<CollisionPair> triggerOverlaps;
+    std::vector<Impact> impacts;
+};
@@ -0,0 +1,80 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "raylib.h"
+#include "renderer.h"
+
+// How an emitter spawns particles
+struct EmitterDesc
+{
+    Rectangle area = {0, 0, 0, 0};   // particles start anywhere inside
+    float rate = 0;                  // particles per second, 0 = bursts only
+    Vector2 minVelocity = {0, 0};
+    Vector2 maxVelocity = {0, 0};
+    float minLifetime = 1;           // seconds
+    float maxLifetime = 1;
+    float size = 1;
+    Color color = WHITE;
+};
+
+// CPU particle system, separate from the entity store.
+//
+// Particles live in SoA columns used as a fixed-capacity ring: new particles
+// are written at the head, the tail moves past particles whose lifetime ran
+// out, and when the ring is full the oldest particle is recycled. Nothing is
+// allocated after construction. Particles don't collide and only move in a
+// straight line, so they never touch the entity list or physics.
+class ParticleSystem
+{
+public:
+    explicit ParticleSystem(uint32_t capacity);
+
+    int AddEmitter(const EmitterDesc& desc);
+    EmitterDesc& GetEmitter(int emitter);
+
+    // Spawn count particles from an emitter right away, optionally
+    // somewhere other than the emitter's area
+    void Burst(int emitter, uint32_t count);
+    void Burst(int emitter, uint32_t count, Rectangle area);
+
+    // Run emitters, move particles and recycle expired ones
+    void Update(float dt);
+    // All live particles as one Renderer::DrawRectangles batch. alpha blends
+    // back towards the previous tick, like Game::Draw
+    void Draw(Renderer& renderer, float alpha = 1.0f) const;
+
+    void Clear();
+
+    uint32_t GetCapacity() const;
+    // Particles between tail and head, including a few that already
+    // expired but haven't reached the tail yet
+    uint32_t GetCount() const;
+
+private:
+    void Emit(const EmitterDesc& desc, Rectangle area, uint32_t amount);
+    void UpdateRange(uint32_t begin, uint32_t end, float dt);
+    float RandomRange(float min, float max);
+
+    // Particle columns
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> velocityX;
+    std::vector<float> velocityY;
+    std::vector<float> life;   // seconds left, <= 0 is dead
+    std::vector<float> size;
+    std::vector<Color> color;
+
+    uint32_t capacity;
+    uint32_t tail = 0;  // oldest particle
+    uint32_t count = 0;
+
+    std::vector<EmitterDesc> emitters;
+    std::vector<float> emitDebt; // fractional particles owed per emitter
+
+    uint32_t randomState = 0x9E3779B9u;
+    float lastDt = 0.0f;
+
+    // Draw scratch, sized to the capacity up front
+    mutable std::vector<Rectangle> drawRects;
+    mutable std::vector<Color> drawColors;
+};
@@ -11,6 +11,13 @@ namespace Physics
     //helper for entity and rectangle
     bool CheckCollision(const Entity& entity, const Rectangle& rect);
 
-    // Resolve collision between two entities
+    // Swept test for boxes starting at a and b and moving by moveA and moveB.
+    // On a hit, time is the fraction of the move at which they first
+    // overlap (0 if they already do)
+    bool SweepTest(const Rectangle& a, Vector2 moveA, const Rectangle& b, Vector2 moveB, float& time);
+
+    // Resolve collision between two entities with one impulse, using their
+    // mass and restitution. Game already solves every contact each tick
+    // (see ContactManager), this is for one-off responses
     void ResolveCollision(Entity& a, Entity& b);
 }
@@ -0,0 +1,114 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "raylib.h"
+
+// Drawing backend. Everything the engine draws goes through one of these,
+// so the same game runs with a window (RaylibRenderer) or without one
+// (NullRenderer, RecordingRenderer) for servers, load tests and benchmarks.
+// The viewport is the visible area in world units, the window size when
+// there is one.
+class Renderer
+{
+public:
+    virtual ~Renderer() = default;
+
+    virtual void BeginFrame(Color background) = 0;
+    virtual void EndFrame() = 0;
+
+    virtual void DrawRectangle(const Rectangle& rect, Color color) = 0;
+    // count rectangles in one call, rects[i] filled with colors[i]. For
+    // anything drawn in bulk (particles), one submission instead of one
+    // virtual call per rectangle
+    virtual void DrawRectangles(const Rectangle* rects, const Color* colors, size_t count) = 0;
+    virtual void DrawText(const char* text, int x, int y, int fontSize, Color color) = 0;
+    virtual int MeasureText(const char* text, int fontSize) const = 0;
+
+    virtual Vector2 GetViewportSize() const = 0;
+};
+
+// Draws with raylib into the window, needs InitWindow first
+class RaylibRenderer : public Renderer
+{
+public:
+    void BeginFrame(Color background) override;
+    void EndFrame() override;
+
+    void DrawRectangle(const Rectangle& rect, Color color) override;
+    void DrawRectangles(const Rectangle* rects, const Color* colors, size_t count) override;
+    void DrawText(const char* text, int x, int y, int fontSize, Color color) override;
+    int MeasureText(const char* text, int fontSize) const override;
+
+    Vector2 GetViewportSize() const override;
+};
+
+// Draws nothing over a fixed virtual viewport, only counts what it was asked
+class NullRenderer : public Renderer
+{
+public:
+    explicit NullRenderer(Vector2 viewportSize);
+
+    void BeginFrame(Color background) override;
+    void EndFrame() override;
+
+    void DrawRectangle(const Rectangle& rect, Color color) override;
+    // Counts as one draw, whatever the count
+    void DrawRectangles(const Rectangle* rects, const Color* colors, size_t count) override;
+    void DrawText(const char* text, int x, int y, int fontSize, Color color) override;
+    // Estimate, half the font size per character
+    int MeasureText(const char* text, int fontSize) const override;
+
+    Vector2 GetViewportSize() const override;
+    void SetViewportSize(Vector2 size);
+
+    size_t GetFrameCount() const { return frames; }
+    // Draw calls in the last finished frame
+    size_t GetDrawCount() const { return lastDraws; }
+
+protected:
+    Vector2 viewport;
+    size_t frames = 0;
+    size_t draws = 0;
+    size_t lastDraws = 0;
+};
+
+// One drawing call kept by RecordingRenderer
+struct RenderCommand
+{
+    enum Type
+    {
+        RECTANGLE,
+        RECTANGLES,
+        TEXT,
+    };
+
+    Type type;
+    Rectangle rect; // text: x, y and the measured width, height = font size,
+                    // rectangles: bounds of the whole batch
+    Color color;    // rectangles: color of the first one
+    std::string text;
+    std::vector<Rectangle> rects; // rectangles only, in submission order
+    std::vector<Color> colors;
+};
+
+// NullRenderer that also keeps the commands of the last finished frame,
+// to check what would have been drawn
+class RecordingRenderer : public NullRenderer
+{
+public:
+    explicit RecordingRenderer(Vector2 viewportSize);
+
+    void BeginFrame(Color background) override;
+    void EndFrame() override;
+
+    void DrawRectangle(const Rectangle& rect, Color color) override;
+    void DrawRectangles(const Rectangle* rects, const Color* colors, size_t count) override;
+    void DrawText(const char* text, int x, int y, int fontSize, Color color) override;
+
+    const std::vector<RenderCommand>& GetCommands() const { return lastFrame; }
+
+private:
+    std::vector<RenderCommand> frame;
+    std::vector<RenderCommand> lastFrame;
+};
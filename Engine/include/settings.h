@@ -9,7 +9,9 @@ struct VideoSettings
     int windowHeight = 600;
     int targetFPS = 60;
     bool fullscreen = false;
-
+    // No window, GPU or input: the game runs on a NullRenderer whose
+    // viewport is windowWidth x windowHeight. For servers and benchmarks
+    bool headless = false;
 };
 
 struct AudioSettings
@@ -19,6 +21,31 @@ struct AudioSettings
     float sfxVolume    = 0.8f;
 };
 
+struct SimulationSettings
+{
+    // Fixed simulation rate, independent of the render frame rate
+    int tickRate = 60;
+    // Ticks allowed per rendered frame before time is dropped
+    int maxTicksPerFrame = 5;
+    // Job system worker threads, 0 = one per core minus the main thread
+    int workerThreads = 0;
+    // Particle ring size, the oldest particles are recycled past this
+    int maxParticles = 65536;
+    // Reproduce runs bit for bit (lockstep, replays): scalar math paths,
+    // ordered contacts, systems one at a time and a state hash every tick,
+    // see Game::GetStateHash
+    bool deterministic = false;
+    // Contact solver passes per tick, more = stiffer stacks
+    int solverIterations = 4;
+    // Seconds a body must be at rest before it sleeps, 0 = never sleep
+    float sleepTime = 0.5f;
+    // Most substeps a fast body can split a tick into (power of two),
+    // 1 disables substepping
+    int maxSubsteps = 8;
+    // Collision broadphase: "grid" (spatial hash) or "sap" (sweep and prune)
+    std::string broadphase = "grid";
+};
+
 struct ControlSettings
 {
     // action name → key
@@ -30,6 +57,7 @@ class Settings
 public:
     VideoSettings video;
     AudioSettings audio;
+    SimulationSettings simulation;
     ControlSettings controls;
 
     // lifecycle
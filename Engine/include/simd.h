@@ -0,0 +1,20 @@
+#pragma once
+
+// Shared setup for the SIMD kernels (integrator.cpp, narrowphase.cpp).
+// Which path runs is decided at runtime, see Integrator::DetectPath
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+    #define TT_X86 1
+    #include <immintrin.h>
+    #ifdef _MSC_VER
+        #include <intrin.h>
+    #endif
+#endif
+
+// GCC/Clang only emit AVX2 instructions in functions that ask for them,
+// MSVC allows the intrinsics anywhere
+#if defined(TT_X86) && (defined(__GNUC__) || defined(__clang__))
+    #define TT_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+    #define TT_TARGET_AVX2
+#endif
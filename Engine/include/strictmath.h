@@ -0,0 +1,33 @@
+#pragma once
+
+// Included first thing by every source file that does simulation math,
+// before its own header, so the pragmas below also cover inline functions
+// pulled in from other headers. Stops the compiler from fusing a * b + c
+// into one FMA, which rounds once instead of twice and is only done when
+// the target CPU has FMA, so results would depend on /arch and -march.
+// GCC has no pragma meant for this, GCC builds pass -ffp-contract=off
+// instead (see compile.bat). The rest is IEEE single or double precision
+// with one rounding per operation under /fp:precise (MSVC's default) or
+// GCC/Clang without -ffast-math.
+#if defined(_MSC_VER) && !defined(__clang__)
+    #pragma fp_contract(off)
+#elif defined(__clang__)
+    #pragma clang fp contract(off)
+#endif
+
+// Fast math allows reassociation and approximations, nothing above helps
+#if defined(__FAST_MATH__) || defined(_M_FP_FAST)
+    #define TT_FAST_MATH 1
+#endif
+
+// Math whose result must not depend on the C runtime. pow, exp, log and
+// sin are only required to be close, different libraries (MSVC, glibc, libc++)
+// round them differently. These use only basic arithmetic, which IEEE
+// rounds the same everywhere.
+namespace StrictMath
+{
+    // base ^ exponent for base >= 0
+    float Pow(float base, float exponent);
+    // sin(x), x in radians, accurate to float for |x| up to about 1e5
+    float Sin(float x);
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+// Bits a system uses to declare which components it reads and writes.
+// COMPONENT_ENTITIES covers the entity set itself: write it to remove
+// entities, read it to look them up by EntityId. Spawning needs no bit,
+// Game::SpawnEntity is safe from systems running in parallel and the new
+// entities only show up after the systems have run.
+// Bits from COMPONENT_USER up are free for game-defined resources.
+enum ComponentMask : uint32_t
+{
+    COMPONENT_NONE        = 0,
+    COMPONENT_POSITION    = 1 << 0,
+    COMPONENT_VELOCITY    = 1 << 1,
+    COMPONENT_SIZE        = 1 << 2,
+    COMPONENT_FRICTION    = 1 << 3,
+    COMPONENT_COLOR       = 1 << 4,
+    COMPONENT_TAGS        = 1 << 5,
+    COMPONENT_ENTITIES    = 1 << 6,
+    COMPONENT_MASS        = 1 << 7,
+    COMPONENT_RESTITUTION = 1 << 8,
+    COMPONENT_FLAGS       = 1 << 9,  // flags, collision layers and masks
+    COMPONENT_SLEEP       = 1 << 10, // sleep state, written by Entity::AddForce and Wake
+    COMPONENT_USER        = 1 << 16,
+};
+
+// Runs registered systems once per tick.
+// Two systems conflict when one writes something the other reads or
+// writes. Each system depends on every earlier-registered system it
+// conflicts with, so registration order is the tie-breaker. Systems are
+// grouped into batches by dependency depth; a batch holds no conflicting
+// systems and is run concurrently on the JobSystem, unless deterministic.
+class SystemScheduler
+{
+public:
+    using SystemFunction = std::function<void(float dt)>;
+
+    void Register(const std::string& name, uint32_t reads, uint32_t writes, SystemFunction function);
+    void Run(float dt);
+
+    // Run each batch's systems one after another in registration order.
+    // Systems in a batch don't conflict, but the order they spawn in
+    // decides which slots new entities get and their row order
+    void SetDeterministic(bool enabled);
+
+    // Indices of the registered systems, one list per batch in run order
+    const std::vector<std::vector<size_t>>& GetBatches();
+    // Print the batches to the console
+    void PrintSchedule();
+
+private:
+    struct System
+    {
+        std::string name;
+        uint32_t reads;
+        uint32_t writes;
+        SystemFunction function;
+    };
+
+    void BuildBatches();
+    static void RunSystem(void* data, size_t begin, size_t end);
+
+    std::vector<System> systems;
+    std::vector<std::vector<size_t>> batches;
+    bool dirty = false;
+    bool deterministic = false;
+    float currentDt = 0.0f;
+};
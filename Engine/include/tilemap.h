@@ -0,0 +1,127 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "entitystore.h"
+#include "raylib.h"
+#include "renderer.h"
+
+// Tile kinds, same values as the editor's TileType
+enum TileType : uint8_t
+{
+    TILE_EMPTY  = 0,
+    TILE_WALL   = 1,
+    TILE_PLAYER = 2, // player start
+    TILE_EXIT   = 3,
+};
+
+// Entity pushed out of a wall by TileMap::Collide
+struct TileHit
+{
+    uint32_t row;
+    int x, y; // tile that stopped it
+    uint32_t collider; // index into TileMap::GetColliders
+    Vector2 normal; // out of the tile
+};
+
+// Closest wall hit by TileMap::Raycast
+struct TileRayHit
+{
+    int x = 0, y = 0;
+    float distance = 0;
+    Vector2 point = {0, 0};
+    Vector2 normal = {0, 0}; // zero if the ray started inside the wall
+};
+
+// Grid level collider. Tiles are square, tileSize world units, with tile
+// (0, 0) at origin. Walls are kept as one bit per tile, packed 64 to a word
+// along each row, so checking a span of a row is a few mask tests. Only the
+// tiles under a box are looked at, the cost doesn't grow with the number
+// of walls. Outside the grid is empty.
+//
+// Bake merges the walls into a few large rectangles (greedy meshing: grow
+// each run of wall tiles right, then down while the rows below match).
+// Those are what gets drawn, one draw call each, and what collisions
+// report as the collider that was hit, so a wall acts as one body however
+// many tiles it is made of. Changing tiles marks the bake stale; Collide
+// and Draw redo it when needed.
+class TileMap
+{
+public:
+    // Clears every tile
+    void Resize(int width, int height);
+    // Level saved by the editor: "width height", then one line per row with
+    // a digit per tile (TileType). Keeps the old level on failure
+    bool Load(const std::string& path);
+
+    void SetOrigin(Vector2 position);
+    void SetTileSize(float size);
+    Vector2 GetOrigin() const { return origin; }
+    float GetTileSize() const { return tileSize; }
+    int GetWidth() const { return width; }
+    int GetHeight() const { return height; }
+
+    void SetTile(int x, int y, TileType type);
+    TileType GetTile(int x, int y) const;
+    bool IsSolid(int x, int y) const;
+    // First tile of type in row order
+    bool FindTile(TileType type, int& x, int& y) const;
+    Rectangle GetTileBounds(int x, int y) const;
+
+    // Merge the walls into colliders, only does work if tiles changed
+    void Bake();
+    // Merged walls in world units, as of the last Bake
+    const std::vector<Rectangle>& GetColliders() const { return colliders; }
+
+    // Entities collide with walls if their mask has this layer
+    void SetCollisionLayer(uint32_t layer);
+    uint32_t GetCollisionLayer() const { return collisionLayer; }
+
+    bool Overlaps(const Rectangle& box) const;
+
+    // Moves every awake entity back out of the walls it moved into this
+    // tick. Each axis is swept from the previous position, x then y, and
+    // stops at the first wall, so fast bodies can't pass through thin ones.
+    // Velocity into the wall is reflected and scaled by restitution.
+    // A body still inside a wall after that (spawned there, or pushed in by
+    // a contact) is moved out the shortest way along x or y, and loses its
+    // velocity back into the wall. Triggers pass through walls
+    void Collide(EntityStore& store);
+    // Entities stopped by the last Collide
+    const std::vector<TileHit>& GetHits() const { return hits; }
+
+    // First wall along the ray (DDA walk over the tiles), direction need
+    // not be normalized
+    bool Raycast(Vector2 origin, Vector2 direction, float maxDistance, TileRayHit& hit) const;
+
+    // One rectangle per collider
+    void Draw(Renderer& renderer, Color color);
+
+private:
+    // Range of tiles a [min, max) span covers along one axis, clamped to
+    // the grid. Empty if first > last
+    void GetSpan(float min, float max, float start, int count, int& first, int& last) const;
+    bool RowHasWall(int y, int firstX, int lastX) const;
+    bool ColumnHasWall(int x, int firstY, int lastY) const;
+    // How far box has to move along an axis (0 = x, 1 = y) in direction
+    // sign to clear every wall. Always finite, outside the grid is empty
+    float EscapeDistance(const Rectangle& box, int axis, int sign) const;
+    // Pushes row out of the walls it overlaps, false if it wasn't in any
+    bool Depenetrate(EntityStore& store, size_t row);
+
+    int width = 0;
+    int height = 0;
+    int wordsPerRow = 0;
+    Vector2 origin = {0, 0};
+    float tileSize = 32.0f;
+    uint32_t collisionLayer = 1;
+
+    std::vector<uint8_t> tiles; // TileType, row major
+    std::vector<uint64_t> walls; // one bit per tile, wordsPerRow words per row
+    std::vector<TileHit> hits;
+
+    bool baked = true;
+    std::vector<Rectangle> colliders;
+    std::vector<uint32_t> tileColliders; // collider of each wall tile, row major
+    std::vector<uint64_t> unmerged; // Bake scratch, walls not yet in a collider
+};
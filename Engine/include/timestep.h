@@ -0,0 +1,24 @@
+#pragma once
+
+// Fixed-timestep accumulator.
+// Frame time is banked and paid out in whole simulation ticks, so the
+// simulation advances at the same rate however fast frames are drawn.
+class FixedTimestep
+{
+public:
+    FixedTimestep(int tickRate, int maxTicksPerFrame);
+
+    // Bank one frame's time and return how many ticks to run now.
+    // Never more than maxTicksPerFrame: time beyond that is dropped, so a
+    // long hitch slows the game down instead of snowballing (spiral of death)
+    int Advance(float frameTime);
+
+    float GetTickDelta() const;
+    // Fraction of the next tick already banked (0..1), for render interpolation
+    float GetAlpha() const;
+
+private:
+    float tickDelta;
+    int maxTicks;
+    float accumulator = 0.0f;
+};
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "broadphase.h"
+#include "entitystore.h"
+
+enum TriggerEventType : uint8_t
+{
+    TRIGGER_ENTER,
+    TRIGGER_EXIT,
+};
+
+// Something started or stopped overlapping a trigger (ENTITY_TRIGGER)
+struct TriggerEvent
+{
+    EntityId trigger;
+    EntityId other; // may already be destroyed for TRIGGER_EXIT
+    TriggerEventType type;
+};
+
+// Overlap state of every trigger, kept across ticks.
+// Each tick gets the trigger pairs the narrowphase confirmed and only the
+// changes become events: pairs not seen last tick enter, pairs that were
+// there last tick and are gone exit (including when either side was
+// destroyed). A pair that stays inside produces nothing, ask IsInside.
+class TriggerTracker
+{
+public:
+    // overlaps are (trigger row, other row), see Narrowphase::GetTriggerOverlaps.
+    // A pair may be listed more than once (several substeps), it counts once
+    void Update(const EntityStore& store, const std::vector<CollisionPair>& overlaps);
+
+    // Changes from the last Update: exits first, then enters
+    const std::vector<TriggerEvent>& GetEvents() const { return events; }
+    bool IsInside(EntityId trigger, EntityId other) const;
+    size_t GetOverlapCount() const { return inside.size(); }
+
+private:
+    struct Inside
+    {
+        EntityId trigger;
+        EntityId other;
+        uint32_t tick;
+    };
+
+    static uint64_t Key(EntityId trigger, EntityId other);
+
+    uint32_t tick = 0;
+    std::unordered_map<uint64_t, Inside> inside; // keyed by handle slots
+    std::vector<TriggerEvent> events;
+    std::vector<TriggerEvent> entered; // scratch
+};
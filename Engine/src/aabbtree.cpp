@@ -0,0 +1,487 @@
+#include "aabbtree.h"
+#include <algorithm>
+#include <cmath>
+#include <cfloat>
+
+// Fat boxes are grown by this much on every side, in world units
+static const float FAT_MARGIN = 4.0f;
+// and stretched along the last move by this many moves
+static const float DISPLACEMENT_MULTIPLIER = 4.0f;
+
+AABBTree::AABBTree()
+    : root(NULL_NODE)
+    , freeList(NULL_NODE)
+    , proxyCount(0)
+{
+}
+
+AABBTree::Bounds AABBTree::ToBounds(const Rectangle& box)
+{
+    return {box.x, box.y, box.x + box.width, box.y + box.height};
+}
+
+AABBTree::Bounds AABBTree::Combine(const Bounds& a, const Bounds& b)
+{
+    return {std::min(a.minX, b.minX), std::min(a.minY, b.minY),
+            std::max(a.maxX, b.maxX), std::max(a.maxY, b.maxY)};
+}
+
+float AABBTree::Perimeter(const Bounds& b)
+{
+    return 2.0f * ((b.maxX - b.minX) + (b.maxY - b.minY));
+}
+
+bool AABBTree::Contains(const Bounds& outer, const Bounds& inner)
+{
+    return outer.minX <= inner.minX && outer.minY <= inner.minY &&
+           inner.maxX <= outer.maxX && inner.maxY <= outer.maxY;
+}
+
+// Same strict test as CheckCollisionRecs, touching boxes don't overlap
+bool AABBTree::Overlaps(const Bounds& a, const Bounds& b)
+{
+    return a.minX < b.maxX && b.minX < a.maxX &&
+           a.minY < b.maxY && b.minY < a.maxY;
+}
+
+float AABBTree::DistanceSquared(const Bounds& b, Vector2 point)
+{
+    float dx = std::max(std::max(b.minX - point.x, point.x - b.maxX), 0.0f);
+    float dy = std::max(std::max(b.minY - point.y, point.y - b.maxY), 0.0f);
+    return dx * dx + dy * dy;
+}
+
+AABBTree::Bounds AABBTree::Fatten(const Bounds& tight, Vector2 displacement)
+{
+    Bounds fat = {tight.minX - FAT_MARGIN, tight.minY - FAT_MARGIN,
+                  tight.maxX + FAT_MARGIN, tight.maxY + FAT_MARGIN};
+
+    // Predict where the box is heading so it stays inside for a few ticks
+    float dx = displacement.x * DISPLACEMENT_MULTIPLIER;
+    float dy = displacement.y * DISPLACEMENT_MULTIPLIER;
+    if (dx < 0) fat.minX += dx; else fat.maxX += dx;
+    if (dy < 0) fat.minY += dy; else fat.maxY += dy;
+    return fat;
+}
+
+int32_t AABBTree::AllocateNode()
+{
+    if (freeList == NULL_NODE)
+    {
+        Node node = {};
+        node.height = -1;
+        node.parent = NULL_NODE;
+        nodes.push_back(node);
+        freeList = (int32_t)nodes.size() - 1;
+    }
+
+    int32_t index = freeList;
+    Node& node = nodes[index];
+    freeList = node.parent;
+    node.parent = NULL_NODE;
+    node.child1 = NULL_NODE;
+    node.child2 = NULL_NODE;
+    node.height = 0;
+    node.userData = 0;
+    return index;
+}
+
+void AABBTree::FreeNode(int32_t index)
+{
+    nodes[index].parent = freeList;
+    nodes[index].height = -1;
+    freeList = index;
+}
+
+int32_t AABBTree::CreateProxy(const Rectangle& box, uint32_t userData)
+{
+    int32_t proxy = AllocateNode();
+    Node& node = nodes[proxy];
+    node.tight = ToBounds(box);
+    node.fat = Fatten(node.tight, {0, 0});
+    node.userData = userData;
+
+    InsertLeaf(proxy);
+    ++proxyCount;
+    return proxy;
+}
+
+void AABBTree::DestroyProxy(int32_t proxy)
+{
+    RemoveLeaf(proxy);
+    FreeNode(proxy);
+    --proxyCount;
+}
+
+bool AABBTree::MoveProxy(int32_t proxy, const Rectangle& box, Vector2 displacement)
+{
+    Node& node = nodes[proxy];
+    node.tight = ToBounds(box);
+
+    if (Contains(node.fat, node.tight))
+    {
+        // Still inside, unless the fat box has become much larger than it
+        // needs to be (the object slowed down), leave the tree alone
+        Bounds fat = Fatten(node.tight, displacement);
+        Bounds huge = {fat.minX - 4 * FAT_MARGIN, fat.minY - 4 * FAT_MARGIN,
+                       fat.maxX + 4 * FAT_MARGIN, fat.maxY + 4 * FAT_MARGIN};
+        if (Contains(huge, node.fat))
+            return false;
+    }
+
+    RemoveLeaf(proxy);
+    nodes[proxy].fat = Fatten(nodes[proxy].tight, displacement);
+    InsertLeaf(proxy);
+    return true;
+}
+
+void AABBTree::Clear()
+{
+    nodes.clear();
+    root = NULL_NODE;
+    freeList = NULL_NODE;
+    proxyCount = 0;
+}
+
+uint32_t AABBTree::GetUserData(int32_t proxy) const
+{
+    return nodes[proxy].userData;
+}
+
+int AABBTree::GetProxyCount() const
+{
+    return proxyCount;
+}
+
+int AABBTree::GetHeight() const
+{
+    return root == NULL_NODE ? 0 : nodes[root].height;
+}
+
+void AABBTree::InsertLeaf(int32_t leaf)
+{
+    if (root == NULL_NODE)
+    {
+        root = leaf;
+        nodes[root].parent = NULL_NODE;
+        return;
+    }
+
+    // Walk down towards the sibling that grows the tree's total perimeter
+    // the least, stopping early when pairing here is already cheaper
+    const Bounds leafBounds = nodes[leaf].fat;
+    int32_t index = root;
+    while (!nodes[index].IsLeaf())
+    {
+        const Node& node = nodes[index];
+        const float perimeter = Perimeter(node.fat);
+        const float combinedPerimeter = Perimeter(Combine(node.fat, leafBounds));
+
+        // Cost of making a new parent for this node and the leaf
+        const float cost = 2.0f * combinedPerimeter;
+        // Cost every ancestor pays for the leaf going further down
+        const float inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+        float childCosts[2];
+        const int32_t children[2] = {node.child1, node.child2};
+        for (int i = 0; i < 2; ++i)
+        {
+            const Node& child = nodes[children[i]];
+            const float grown = Perimeter(Combine(leafBounds, child.fat));
+            childCosts[i] = child.IsLeaf() ? grown + inheritanceCost
+                                           : (grown - Perimeter(child.fat)) + inheritanceCost;
+        }
+
+        if (cost < childCosts[0] && cost < childCosts[1])
+            break;
+
+        index = childCosts[0] < childCosts[1] ? children[0] : children[1];
+    }
+
+    const int32_t sibling = index;
+    const int32_t oldParent = nodes[sibling].parent;
+    const int32_t newParent = AllocateNode();
+    nodes[newParent].parent = oldParent;
+    nodes[newParent].fat = Combine(leafBounds, nodes[sibling].fat);
+    nodes[newParent].height = nodes[sibling].height + 1;
+    nodes[newParent].child1 = sibling;
+    nodes[newParent].child2 = leaf;
+    nodes[sibling].parent = newParent;
+    nodes[leaf].parent = newParent;
+
+    if (oldParent == NULL_NODE)
+    {
+        root = newParent;
+    }
+    else if (nodes[oldParent].child1 == sibling)
+    {
+        nodes[oldParent].child1 = newParent;
+    }
+    else
+    {
+        nodes[oldParent].child2 = newParent;
+    }
+
+    Refit(nodes[leaf].parent);
+}
+
+void AABBTree::RemoveLeaf(int32_t leaf)
+{
+    if (leaf == root)
+    {
+        root = NULL_NODE;
+        return;
+    }
+
+    // The leaf's parent goes away and the sibling takes its place
+    const int32_t parent = nodes[leaf].parent;
+    const int32_t grandParent = nodes[parent].parent;
+    const int32_t sibling = nodes[parent].child1 == leaf ? nodes[parent].child2 : nodes[parent].child1;
+
+    if (grandParent == NULL_NODE)
+    {
+        root = sibling;
+        nodes[sibling].parent = NULL_NODE;
+        FreeNode(parent);
+        return;
+    }
+
+    if (nodes[grandParent].child1 == parent)
+        nodes[grandParent].child1 = sibling;
+    else
+        nodes[grandParent].child2 = sibling;
+    nodes[sibling].parent = grandParent;
+    FreeNode(parent);
+
+    Refit(grandParent);
+}
+
+// Rebalance and recompute bounds from node up to the root
+void AABBTree::Refit(int32_t index)
+{
+    while (index != NULL_NODE)
+    {
+        index = Balance(index);
+
+        Node& node = nodes[index];
+        node.height = 1 + std::max(nodes[node.child1].height, nodes[node.child2].height);
+        node.fat = Combine(nodes[node.child1].fat, nodes[node.child2].fat);
+
+        index = node.parent;
+    }
+}
+
+// If one child of a is two levels taller than the other, rotate the taller
+// child up into a's place. Returns the index now at a's position
+int32_t AABBTree::Balance(int32_t a)
+{
+    Node& A = nodes[a];
+    if (A.IsLeaf() || A.height < 2)
+        return a;
+
+    const int32_t b = A.child1;
+    const int32_t c = A.child2;
+    const int32_t balance = nodes[c].height - nodes[b].height;
+
+    // Rotate c up (or b, mirrored) and hang its shorter child under a
+    auto rotateUp = [&](int32_t up, int32_t other, bool upIsChild2) -> int32_t
+    {
+        Node& U = nodes[up];
+        const int32_t f = U.child1;
+        const int32_t g = U.child2;
+
+        // up takes a's place
+        U.child1 = a;
+        U.parent = A.parent;
+        A.parent = up;
+
+        if (U.parent != NULL_NODE)
+        {
+            if (nodes[U.parent].child1 == a)
+                nodes[U.parent].child1 = up;
+            else
+                nodes[U.parent].child2 = up;
+        }
+        else
+        {
+            root = up;
+        }
+
+        // The taller grandchild stays with up, the shorter one moves to a
+        int32_t keep = f;
+        int32_t give = g;
+        if (nodes[f].height < nodes[g].height)
+        {
+            keep = g;
+            give = f;
+        }
+
+        U.child2 = keep;
+        if (upIsChild2)
+            A.child2 = give;
+        else
+            A.child1 = give;
+        nodes[give].parent = a;
+
+        A.fat = Combine(nodes[other].fat, nodes[give].fat);
+        A.height = 1 + std::max(nodes[other].height, nodes[give].height);
+        U.fat = Combine(A.fat, nodes[keep].fat);
+        U.height = 1 + std::max(A.height, nodes[keep].height);
+        return up;
+    };
+
+    if (balance > 1)
+        return rotateUp(c, b, true);
+    if (balance < -1)
+        return rotateUp(b, c, false);
+    return a;
+}
+
+void AABBTree::QueryBox(const Rectangle& box, std::vector<uint32_t>& results) const
+{
+    Query(box, [&results](uint32_t userData) { results.push_back(userData); });
+}
+
+// Entry and exit distances of the ray through one slab
+static bool RaySlab(float min, float max, float origin, float direction, float& tNear, float& tFar)
+{
+    if (direction == 0)
+    {
+        // Parallel: inside the slab for the whole ray, or never
+        if (origin <= min || origin >= max)
+            return false;
+        tNear = -FLT_MAX;
+        tFar = FLT_MAX;
+        return true;
+    }
+
+    float t1 = (min - origin) / direction;
+    float t2 = (max - origin) / direction;
+    tNear = std::min(t1, t2);
+    tFar = std::max(t1, t2);
+    return true;
+}
+
+// Returns the entry distance along the ray, or -1 on a miss.
+// axis gets which slab was entered last (0 = x, 1 = y)
+static float RayBox(float minX, float minY, float maxX, float maxY, Vector2 origin, Vector2 direction, float maxDistance, int& axis)
+{
+    float txNear, txFar, tyNear, tyFar;
+    if (!RaySlab(minX, maxX, origin.x, direction.x, txNear, txFar) ||
+        !RaySlab(minY, maxY, origin.y, direction.y, tyNear, tyFar))
+        return -1.0f;
+
+    float tNear = std::max(txNear, tyNear);
+    float tFar = std::min(txFar, tyFar);
+    if (tNear > tFar || tFar < 0 || tNear > maxDistance)
+        return -1.0f;
+
+    axis = txNear > tyNear ? 0 : 1;
+    return std::max(tNear, 0.0f);
+}
+
+bool AABBTree::Raycast(Vector2 origin, Vector2 direction, float maxDistance, TreeRayHit& hit, uint32_t ignore) const
+{
+    const float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+    if (root == NULL_NODE || length <= 0)
+        return false;
+
+    const Vector2 dir = {direction.x / length, direction.y / length};
+
+    bool found = false;
+    float best = maxDistance;
+
+    NodeStack stack;
+    stack.Push(root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+
+        const Node& node = nodes[index];
+        int axis = 0;
+        const Bounds& fat = node.fat;
+        if (RayBox(fat.minX, fat.minY, fat.maxX, fat.maxY, origin, dir, best, axis) < 0)
+            continue;
+
+        if (!node.IsLeaf())
+        {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+            continue;
+        }
+
+        if (node.userData == ignore)
+            continue;
+
+        const Bounds& tight = node.tight;
+        const bool inside = origin.x > tight.minX && origin.x < tight.maxX &&
+                            origin.y > tight.minY && origin.y < tight.maxY;
+        if (inside)
+            continue;
+
+        const float t = RayBox(tight.minX, tight.minY, tight.maxX, tight.maxY, origin, dir, best, axis);
+        if (t < 0 || (found && t >= best))
+            continue;
+
+        found = true;
+        best = t;
+        hit.userData = node.userData;
+        hit.distance = t;
+        hit.point = {origin.x + dir.x * t, origin.y + dir.y * t};
+        if (axis == 0)
+            hit.normal = {dir.x > 0 ? -1.0f : 1.0f, 0};
+        else
+            hit.normal = {0, dir.y > 0 ? -1.0f : 1.0f};
+    }
+    return found;
+}
+
+bool AABBTree::QueryNearest(Vector2 point, float maxDistance, uint32_t& userData, uint32_t ignore) const
+{
+    if (root == NULL_NODE)
+        return false;
+
+    bool found = false;
+    float best = maxDistance * maxDistance;
+
+    // Depth first, nearer child first so the bound tightens quickly
+    NodeStack stack;
+    stack.Push(root);
+    while (!stack.IsEmpty())
+    {
+        const int32_t index = stack.Pop();
+
+        const Node& node = nodes[index];
+        if (DistanceSquared(node.fat, point) > best)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            if (node.userData == ignore)
+                continue;
+
+            const float distance = DistanceSquared(node.tight, point);
+            if (distance <= best && (!found || distance < best))
+            {
+                found = true;
+                best = distance;
+                userData = node.userData;
+            }
+            continue;
+        }
+
+        const float d1 = DistanceSquared(nodes[node.child1].fat, point);
+        const float d2 = DistanceSquared(nodes[node.child2].fat, point);
+        if (d1 < d2)
+        {
+            stack.Push(node.child2);
+            stack.Push(node.child1);
+        }
+        else
+        {
+            stack.Push(node.child1);
+            stack.Push(node.child2);
+        }
+    }
+    return found;
+}
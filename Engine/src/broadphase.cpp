@@ -0,0 +1,466 @@
+#include "broadphase.h"
+#include <algorithm>
+#include <cmath>
+
+// Cells an entity may be inserted into per axis. Bigger ones would flood
+// the table, they are tested against everything instead
+static const int32_t MAX_CELLS_PER_AXIS = 16;
+
+// Layer/mask filter, both sides have to accept the other
+static bool CanCollide(const EntityStore& store, uint32_t a, uint32_t b)
+{
+    return (store.collisionLayers[a] & store.collisionMasks[b]) != 0 &&
+           (store.collisionLayers[b] & store.collisionMasks[a]) != 0;
+}
+
+// Bounds an entity is tested with: everything it covered this tick, so a
+// bullet's sweep finds anything on the way even if that moved too. The
+// narrowphase still checks non-bullet pairs at their final positions
+static void GetBounds(const EntityStore& store, size_t row, float& minX, float& minY, float& maxX, float& maxY)
+{
+    const Vector3& position = store.positions[row];
+    const Vector3& previous = store.previousPositions[row];
+    const Vector3& size = store.sizes[row];
+    minX = fminf(position.x, previous.x);
+    minY = fminf(position.y, previous.y);
+    maxX = fmaxf(position.x, previous.x) + size.x;
+    maxY = fmaxf(position.y, previous.y) + size.y;
+}
+
+SpatialHashGrid::SpatialHashGrid(float cellSize)
+{
+    SetCellSize(cellSize);
+}
+
+void SpatialHashGrid::SetCellSize(float size)
+{
+    cellSize = size > 0.0f ? size : 64.0f;
+    inverseCellSize = 1.0f / cellSize;
+}
+
+float SpatialHashGrid::GetCellSize() const
+{
+    return cellSize;
+}
+
+int32_t SpatialHashGrid::CellOf(float coordinate) const
+{
+    return (int32_t)floorf(coordinate * inverseCellSize);
+}
+
+uint32_t SpatialHashGrid::Bucket(int32_t cellX, int32_t cellY) const
+{
+    // Large primes, spreads neighbouring cells across the table
+    const uint32_t hash = (uint32_t)cellX * 73856093u ^ (uint32_t)cellY * 19349663u;
+    return hash & bucketMask;
+}
+
+void SpatialHashGrid::Update(const EntityStore& store)
+{
+    pairs.clear();
+    entries.clear();
+    oversized.clear();
+
+    // Insert every live entity into the cells its bounds cover
+    const size_t count = store.Count();
+    for (size_t row = 0; row < count; ++row)
+    {
+        if (!store.IsRowAlive(row) || (store.flags[row] & ENTITY_NO_COLLISION))
+            continue;
+
+        float boundsMinX, boundsMinY, boundsMaxX, boundsMaxY;
+        GetBounds(store, row, boundsMinX, boundsMinY, boundsMaxX, boundsMaxY);
+
+        const int32_t minX = CellOf(boundsMinX);
+        const int32_t minY = CellOf(boundsMinY);
+        const int32_t maxX = CellOf(boundsMaxX);
+        const int32_t maxY = CellOf(boundsMaxY);
+        if (maxX - minX >= MAX_CELLS_PER_AXIS || maxY - minY >= MAX_CELLS_PER_AXIS)
+        {
+            oversized.push_back((uint32_t)row);
+            continue;
+        }
+
+        for (int32_t y = minY; y <= maxY; ++y)
+            for (int32_t x = minX; x <= maxX; ++x)
+                entries.push_back({x, y, (uint32_t)row, boundsMinX, boundsMinY});
+    }
+
+    AddOversizedPairs(store);
+
+    if (entries.size() < 2)
+        return;
+
+    // Table at least twice the entry count keeps buckets short
+    uint32_t bucketCount = 1024;
+    while (bucketCount < entries.size() * 2)
+        bucketCount <<= 1;
+    bucketMask = bucketCount - 1;
+
+    // Counting sort of the entries by bucket, linear in the entry count
+    bucketStart.assign(bucketCount + 1, 0);
+    for (const Entry& entry : entries)
+        bucketStart[Bucket(entry.cellX, entry.cellY) + 1]++;
+    for (uint32_t i = 0; i < bucketCount; ++i)
+        bucketStart[i + 1] += bucketStart[i];
+
+    sorted.resize(entries.size());
+    for (const Entry& entry : entries)
+    {
+        const uint32_t bucket = Bucket(entry.cellX, entry.cellY);
+        // bucketStart[bucket] walks forward as entries land, then ends up
+        // at the old start of the next bucket
+        sorted[bucketStart[bucket]++] = entry;
+    }
+
+    // Pairs within each bucket. After the scatter, bucket b spans
+    // [bucketStart[b - 1], bucketStart[b])
+    uint32_t begin = 0;
+    for (uint32_t bucket = 0; bucket < bucketCount; ++bucket)
+    {
+        const uint32_t end = bucketStart[bucket];
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const Entry& first = sorted[i];
+            for (uint32_t j = i + 1; j < end; ++j)
+            {
+                const Entry& second = sorted[j];
+
+                // Different cells can hash to the same bucket
+                if (first.cellX != second.cellX || first.cellY != second.cellY || first.row == second.row)
+                    continue;
+
+                // Only report from the cell holding the overlap's top-left corner
+                if (CellOf(fmaxf(first.minX, second.minX)) != first.cellX || CellOf(fmaxf(first.minY, second.minY)) != first.cellY)
+                    continue;
+
+                if (!CanCollide(store, first.row, second.row))
+                    continue;
+
+                if (first.row < second.row)
+                    pairs.push_back({first.row, second.row});
+                else
+                    pairs.push_back({second.row, first.row});
+            }
+        }
+        begin = end;
+    }
+}
+
+// Brute force, each oversized row against every other row. There are
+// only ever a few (level-sized walls, runaway bodies)
+void SpatialHashGrid::AddOversizedPairs(const EntityStore& store)
+{
+    if (oversized.empty())
+        return;
+
+    const size_t count = store.Count();
+    isOversized.assign(count, 0);
+    for (uint32_t row : oversized)
+        isOversized[row] = 1;
+
+    for (size_t i = 0; i < oversized.size(); ++i)
+    {
+        const uint32_t big = oversized[i];
+        float minX, minY, maxX, maxY;
+        GetBounds(store, big, minX, minY, maxX, maxY);
+
+        for (size_t row = 0; row < count; ++row)
+        {
+            // Pairs of oversized rows are reported by the lower one
+            if (row == big || (isOversized[row] && row < big))
+                continue;
+            if (!store.IsRowAlive(row) || (store.flags[row] & ENTITY_NO_COLLISION) || !CanCollide(store, big, (uint32_t)row))
+                continue;
+
+            float otherMinX, otherMinY, otherMaxX, otherMaxY;
+            GetBounds(store, row, otherMinX, otherMinY, otherMaxX, otherMaxY);
+            if (minX >= otherMaxX || otherMinX >= maxX || minY >= otherMaxY || otherMinY >= maxY)
+                continue;
+
+            if (big < row)
+                pairs.push_back({big, (uint32_t)row});
+            else
+                pairs.push_back({(uint32_t)row, big});
+        }
+    }
+}
+
+// Sort key for endpoints. At equal values maxes go first, so boxes that
+// only touch are ordered as separated, same as CheckCollisionRecs
+static bool EndpointLess(float aValue, bool aIsMax, float bValue, bool bIsMax)
+{
+    if (aValue != bValue)
+        return aValue < bValue;
+    return aIsMax && !bIsMax;
+}
+
+uint64_t SweepAndPrune::PairKey(uint32_t a, uint32_t b)
+{
+    if (a > b)
+    {
+        uint32_t swap = a;
+        a = b;
+        b = swap;
+    }
+    return ((uint64_t)a << 32) | b;
+}
+
+bool SweepAndPrune::Overlaps(uint32_t a, uint32_t b) const
+{
+    const Proxy& pa = proxies[a];
+    const Proxy& pb = proxies[b];
+    if ((pa.layer & pb.mask) == 0 || (pb.layer & pa.mask) == 0)
+        return false;
+    return pa.min[0] < pb.max[0] && pb.min[0] < pa.max[0] &&
+           pa.min[1] < pb.max[1] && pb.min[1] < pa.max[1];
+}
+
+void SweepAndPrune::AddPair(uint32_t a, uint32_t b)
+{
+    if (pairSet.insert(PairKey(a, b)).second)
+        addedPairs.push_back({proxies[a].id, proxies[b].id});
+}
+
+void SweepAndPrune::RemovePair(uint32_t a, uint32_t b)
+{
+    if (pairSet.erase(PairKey(a, b)) > 0)
+        removedPairs.push_back({proxies[a].id, proxies[b].id});
+}
+
+void SweepAndPrune::Update(const EntityStore& store)
+{
+    addedPairs.clear();
+    removedPairs.clear();
+    added.clear();
+
+    for (Proxy& proxy : proxies)
+        proxy.seen = false;
+
+    // Match rows to proxies by handle slot, a new generation in the same
+    // slot is a different entity
+    const size_t count = store.Count();
+    for (size_t row = 0; row < count; ++row)
+    {
+        if (!store.IsRowAlive(row) || (store.flags[row] & ENTITY_NO_COLLISION))
+            continue;
+
+        const EntityId id = store.ids[row];
+        if (id.index >= proxies.size())
+            proxies.resize(id.index + 1);
+
+        Proxy& proxy = proxies[id.index];
+        if (proxy.active && proxy.id != id)
+        {
+            // Slot reused since the last tick. The old entity's endpoints
+            // and pairs are dropped below, the new one is added right away
+            proxy.replaced = true;
+            proxy.replacedId = proxy.id;
+            proxy.active = false;
+        }
+
+        if (!proxy.active)
+        {
+            proxy.active = true;
+            proxy.id = id;
+            added.push_back(id.index);
+        }
+
+        proxy.seen = true;
+        proxy.row = (uint32_t)row;
+        proxy.layer = store.collisionLayers[row];
+        proxy.mask = store.collisionMasks[row];
+        GetBounds(store, row, proxy.min[0], proxy.min[1], proxy.max[0], proxy.max[1]);
+    }
+
+    RemoveStaleProxies();
+
+    // Refresh endpoint values, existing endpoints are still in last tick's order
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        for (Endpoint& endpoint : axes[axis])
+        {
+            const Proxy& proxy = proxies[endpoint.proxy];
+            endpoint.value = endpoint.isMax ? proxy.max[axis] : proxy.min[axis];
+        }
+    }
+
+    // New proxies start past the end of both axes, which is a valid
+    // "overlaps nothing" state; insertion sort then walks them into place
+    for (uint32_t index : added)
+    {
+        const Proxy& proxy = proxies[index];
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            axes[axis].push_back({proxy.min[axis], index, false});
+            axes[axis].push_back({proxy.max[axis], index, true});
+        }
+    }
+
+    // Walking many new proxies across the whole axis is quadratic, sort
+    // from scratch instead
+    if (added.size() > 64 && added.size() * 4 > axes[0].size() / 2)
+    {
+        Rebuild();
+    }
+    else
+    {
+        SortAxis(0);
+        SortAxis(1);
+    }
+
+    pairs.clear();
+    for (uint64_t key : pairSet)
+    {
+        uint32_t a = proxies[(uint32_t)(key >> 32)].row;
+        uint32_t b = proxies[(uint32_t)key].row;
+        if (a < b)
+            pairs.push_back({a, b});
+        else
+            pairs.push_back({b, a});
+    }
+}
+
+// Drops the endpoints and pairs of proxies whose entity is gone, or whose
+// slot now holds a new entity (those are in added, their endpoints go in
+// after this)
+void SweepAndPrune::RemoveStaleProxies()
+{
+    bool anyStale = false;
+    for (Proxy& proxy : proxies)
+    {
+        if (proxy.active && !proxy.seen)
+        {
+            proxy.active = false;
+            anyStale = true;
+        }
+        if (proxy.replaced)
+            anyStale = true;
+    }
+    if (!anyStale)
+        return;
+
+    auto isStale = [this](uint32_t index)
+    {
+        return !proxies[index].active || proxies[index].replaced;
+    };
+    // Removal events name the entity the pair belonged to
+    auto oldId = [this](uint32_t index)
+    {
+        return proxies[index].replaced ? proxies[index].replacedId : proxies[index].id;
+    };
+
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        std::vector<Endpoint>& endpoints = axes[axis];
+        size_t write = 0;
+        for (size_t read = 0; read < endpoints.size(); ++read)
+        {
+            if (!isStale(endpoints[read].proxy))
+                endpoints[write++] = endpoints[read];
+        }
+        endpoints.resize(write);
+    }
+
+    for (auto it = pairSet.begin(); it != pairSet.end(); )
+    {
+        const uint32_t a = (uint32_t)(*it >> 32);
+        const uint32_t b = (uint32_t)*it;
+        if (isStale(a) || isStale(b))
+        {
+            removedPairs.push_back({oldId(a), oldId(b)});
+            it = pairSet.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    for (Proxy& proxy : proxies)
+        proxy.replaced = false;
+}
+
+void SweepAndPrune::SortAxis(int axis)
+{
+    std::vector<Endpoint>& endpoints = axes[axis];
+
+    for (size_t i = 1; i < endpoints.size(); ++i)
+    {
+        const Endpoint moving = endpoints[i];
+        size_t j = i;
+
+        while (j > 0 && EndpointLess(moving.value, moving.isMax, endpoints[j - 1].value, endpoints[j - 1].isMax))
+        {
+            const Endpoint& passed = endpoints[j - 1];
+
+            // A min moving left past a max: may start overlapping.
+            // A max moving left past a min: stopped overlapping on this axis
+            if (!moving.isMax && passed.isMax)
+            {
+                if (Overlaps(moving.proxy, passed.proxy))
+                    AddPair(moving.proxy, passed.proxy);
+            }
+            else if (moving.isMax && !passed.isMax)
+            {
+                RemovePair(moving.proxy, passed.proxy);
+            }
+
+            endpoints[j] = endpoints[j - 1];
+            --j;
+        }
+        endpoints[j] = moving;
+    }
+}
+
+void SweepAndPrune::Rebuild()
+{
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        std::sort(axes[axis].begin(), axes[axis].end(), [](const Endpoint& a, const Endpoint& b)
+        {
+            return EndpointLess(a.value, a.isMax, b.value, b.isMax);
+        });
+    }
+
+    // Sweep along x: every proxy still open when a min is reached overlaps
+    // it on x, check y to finish the test
+    std::unordered_set<uint64_t> current;
+    std::vector<uint32_t> open;
+    for (const Endpoint& endpoint : axes[0])
+    {
+        if (endpoint.isMax)
+        {
+            for (size_t i = 0; i < open.size(); ++i)
+            {
+                if (open[i] == endpoint.proxy)
+                {
+                    open[i] = open.back();
+                    open.pop_back();
+                    break;
+                }
+            }
+            continue;
+        }
+
+        for (uint32_t other : open)
+        {
+            if (Overlaps(endpoint.proxy, other))
+                current.insert(PairKey(endpoint.proxy, other));
+        }
+        open.push_back(endpoint.proxy);
+    }
+
+    // Events are the difference between the old and new pair sets
+    for (uint64_t key : pairSet)
+    {
+        if (!current.count(key))
+            removedPairs.push_back({proxies[(uint32_t)(key >> 32)].id, proxies[(uint32_t)key].id});
+    }
+    for (uint64_t key : current)
+    {
+        if (!pairSet.count(key))
+            addedPairs.push_back({proxies[(uint32_t)(key >> 32)].id, proxies[(uint32_t)key].id});
+    }
+    pairSet.swap(current);
+}
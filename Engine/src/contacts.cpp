@@ -0,0 +1,296 @@
+#include "strictmath.h"
+#include "contacts.h"
+#include <algorithm>
+#include <cmath>
+#include "jobsystem.h"
+
+// Overlap left alone so resting contacts don't flicker in and out
+static const float PENETRATION_SLOP = 0.5f;
+// Fraction of the remaining overlap removed per position pass
+static const float POSITION_CORRECTION = 0.8f;
+// Impacts slower than this (units per second) don't bounce, lets piles settle
+static const float RESTITUTION_THRESHOLD = 20.0f;
+// Cached impulses are reused only if the normal has barely turned
+static const float WARM_START_COSINE = 0.9f;
+// Smallest batch of constraints worth handing to another thread
+static const size_t SOLVE_CHUNK = 256;
+
+void ContactManager::SetIterations(int count)
+{
+    iterations = count > 0 ? count : 1;
+}
+
+int ContactManager::GetIterations() const
+{
+    return iterations;
+}
+
+void ContactManager::SetDeterministic(bool enabled)
+{
+    deterministic = enabled;
+}
+
+size_t ContactManager::GetColorCount() const
+{
+    size_t count = 0;
+    for (size_t color = 0; color + 1 < colorOffsets.size(); ++color)
+    {
+        if (colorOffsets[color + 1] > colorOffsets[color])
+            ++count;
+    }
+    return count;
+}
+
+size_t ContactManager::GetContactCount() const
+{
+    return constraints.size();
+}
+
+void ContactManager::Update(EntityStore& store, const std::vector<CollisionPair>& overlaps)
+{
+    ++tick;
+    constraints.clear();
+
+    const size_t rows = store.Count();
+    inverseMasses.resize(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const bool movable = store.IsRowActive(i) && store.masses[i] > 0;
+        inverseMasses[i] = movable ? 1.0f / store.masses[i] : 0.0f;
+    }
+
+    // Build the constraints and pick up the last Update's impulses
+    for (const CollisionPair& pair : overlaps)
+    {
+        const float inverseMass = inverseMasses[pair.a] + inverseMasses[pair.b];
+        if (inverseMass == 0)
+            continue;
+
+        const Vector3& positionA = store.positions[pair.a];
+        const Vector3& sizeA = store.sizes[pair.a];
+        const Vector3& positionB = store.positions[pair.b];
+        const Vector3& sizeB = store.sizes[pair.b];
+
+        // Push out along the axis with the least overlap
+        const float overlapX = fminf(positionA.x + sizeA.x, positionB.x + sizeB.x) - fmaxf(positionA.x, positionB.x);
+        const float overlapY = fminf(positionA.y + sizeA.y, positionB.y + sizeB.y) - fmaxf(positionA.y, positionB.y);
+        const float deltaX = (positionB.x + sizeB.x * 0.5f) - (positionA.x + sizeA.x * 0.5f);
+        const float deltaY = (positionB.y + sizeB.y * 0.5f) - (positionA.y + sizeA.y * 0.5f);
+
+        Constraint constraint = {};
+        constraint.a = pair.a;
+        constraint.b = pair.b;
+        if (overlapX < overlapY)
+            constraint.normalX = deltaX < 0 ? -1.0f : 1.0f;
+        else
+            constraint.normalY = deltaY < 0 ? -1.0f : 1.0f;
+        constraint.normalMass = 1.0f / inverseMass;
+
+        // Fast impacts bounce off their approach speed
+        const Vector3& velocityA = store.velocities[pair.a];
+        const Vector3& velocityB = store.velocities[pair.b];
+        const float approach = (velocityB.x - velocityA.x) * constraint.normalX + (velocityB.y - velocityA.y) * constraint.normalY;
+        const float restitution = fmaxf(store.restitutions[pair.a], store.restitutions[pair.b]);
+        constraint.bias = approach < -RESTITUTION_THRESHOLD ? -restitution * approach : 0.0f;
+
+        // Key by handle slot, lower slot first so the key doesn't depend on row order
+        const EntityId idA = store.ids[pair.a];
+        const EntityId idB = store.ids[pair.b];
+        const bool swapped = idA.index > idB.index;
+        const uint64_t key = swapped ? ((uint64_t)idB.index << 32 | idA.index) : ((uint64_t)idA.index << 32 | idB.index);
+        const EntityId first = swapped ? idB : idA;
+        const EntityId second = swapped ? idA : idB;
+
+        constraint.key = key;
+        CachedContact& cached = cache[key];
+        const float sign = swapped ? -1.0f : 1.0f; // cached normal points from first to second
+        const bool reuse = cached.tick == tick - 1 && cached.a == first && cached.b == second &&
+                           (cached.normalX * constraint.normalX + cached.normalY * constraint.normalY) * sign > WARM_START_COSINE;
+
+        constraint.impulse = reuse ? cached.impulse : 0.0f;
+        cached = { first, second, constraint.normalX * sign, constraint.normalY * sign, constraint.impulse, tick };
+        constraint.cached = &cached;
+
+        constraints.push_back(constraint);
+    }
+
+    // Forget contacts that ended. References into the map survive both the
+    // inserts above and erasing other entries
+    for (auto it = cache.begin(); it != cache.end(); )
+    {
+        if (it->second.tick != tick)
+            it = cache.erase(it);
+        else
+            ++it;
+    }
+
+    if (deterministic)
+    {
+        // Order by entity handles instead of by whatever order the
+        // broadphase reported the pairs in
+        std::sort(constraints.begin(), constraints.end(), [](const Constraint& a, const Constraint& b)
+        {
+            return a.key < b.key;
+        });
+    }
+
+    AssignColors(rows);
+
+    // Constraints of one color share no movable body, so each color is
+    // solved in parallel and gives the same result however it is split
+    ForEachColor([&](Constraint& constraint) { WarmStart(store, constraint); });
+    for (int iteration = 0; iteration < iterations; ++iteration)
+        ForEachColor([&](Constraint& constraint) { SolveVelocity(store, constraint); });
+
+    for (const Constraint& constraint : constraints)
+        constraint.cached->impulse = constraint.impulse;
+
+    // Overlap is pushed out by moving positions directly rather than with
+    // extra velocity, which would be carried into next tick's warm start
+    // and make stacks bounce
+    for (int iteration = 0; iteration < iterations; ++iteration)
+        ForEachColor([&](Constraint& constraint) { SolvePosition(store, constraint); });
+}
+
+void ContactManager::AssignColors(size_t rows)
+{
+    // Greedy: each constraint takes the lowest color neither of its movable
+    // bodies has yet. Immovable bodies are only read, so they can be shared
+    bodyColors.assign(rows, 0);
+    colorOf.resize(constraints.size());
+    colorOffsets.assign(MAX_COLORS + 2, 0);
+
+    for (size_t i = 0; i < constraints.size(); ++i)
+    {
+        const Constraint& constraint = constraints[i];
+        const bool movableA = inverseMasses[constraint.a] != 0;
+        const bool movableB = inverseMasses[constraint.b] != 0;
+
+        uint64_t used = 0;
+        if (movableA) used |= bodyColors[constraint.a];
+        if (movableB) used |= bodyColors[constraint.b];
+
+        // Past MAX_COLORS everything goes into one last batch run serially
+        uint32_t color = 0;
+        while (color < MAX_COLORS && (used & (1ull << color)))
+            ++color;
+
+        if (color < MAX_COLORS)
+        {
+            if (movableA) bodyColors[constraint.a] |= 1ull << color;
+            if (movableB) bodyColors[constraint.b] |= 1ull << color;
+        }
+
+        colorOf[i] = color;
+        ++colorOffsets[color + 1];
+    }
+
+    for (uint32_t color = 0; color <= MAX_COLORS; ++color)
+        colorOffsets[color + 1] += colorOffsets[color];
+
+    // Stable counting sort into color order
+    colored.resize(constraints.size());
+    colorCursor.assign(colorOffsets.begin(), colorOffsets.end() - 1);
+    for (size_t i = 0; i < constraints.size(); ++i)
+        colored[colorCursor[colorOf[i]]++] = constraints[i];
+    constraints.swap(colored);
+}
+
+template <typename Function>
+void ContactManager::ForEachColor(const Function& function)
+{
+    for (uint32_t color = 0; color <= MAX_COLORS; ++color)
+    {
+        const uint32_t begin = colorOffsets[color];
+        const uint32_t end = colorOffsets[color + 1];
+        if (begin == end)
+            continue;
+
+        Constraint* batch = constraints.data() + begin;
+        if (color == MAX_COLORS)
+        {
+            for (uint32_t i = 0; i < end - begin; ++i)
+                function(batch[i]);
+            continue;
+        }
+
+        JobSystem::ParallelFor(end - begin, SOLVE_CHUNK, [&](size_t first, size_t last)
+        {
+            for (size_t i = first; i < last; ++i)
+                function(batch[i]);
+        });
+    }
+}
+
+// Bodies with no inverse mass are never written, other constraints in the
+// same color may be reading them
+void ContactManager::ApplyImpulse(EntityStore& store, const Constraint& constraint, float impulse)
+{
+    const float impulseX = constraint.normalX * impulse;
+    const float impulseY = constraint.normalY * impulse;
+    const float inverseMassA = inverseMasses[constraint.a];
+    const float inverseMassB = inverseMasses[constraint.b];
+
+    if (inverseMassA != 0)
+    {
+        Vector3& velocityA = store.velocities[constraint.a];
+        velocityA.x -= impulseX * inverseMassA;
+        velocityA.y -= impulseY * inverseMassA;
+    }
+    if (inverseMassB != 0)
+    {
+        Vector3& velocityB = store.velocities[constraint.b];
+        velocityB.x += impulseX * inverseMassB;
+        velocityB.y += impulseY * inverseMassB;
+    }
+}
+
+void ContactManager::WarmStart(EntityStore& store, Constraint& constraint)
+{
+    ApplyImpulse(store, constraint, constraint.impulse);
+}
+
+void ContactManager::SolveVelocity(EntityStore& store, Constraint& constraint)
+{
+    const Vector3& velocityA = store.velocities[constraint.a];
+    const Vector3& velocityB = store.velocities[constraint.b];
+
+    const float separating = (velocityB.x - velocityA.x) * constraint.normalX + (velocityB.y - velocityA.y) * constraint.normalY;
+    float delta = constraint.normalMass * (constraint.bias - separating);
+
+    // The total impulse may only push apart
+    const float total = fmaxf(constraint.impulse + delta, 0.0f);
+    delta = total - constraint.impulse;
+    constraint.impulse = total;
+
+    ApplyImpulse(store, constraint, delta);
+}
+
+void ContactManager::SolvePosition(EntityStore& store, Constraint& constraint)
+{
+    Vector3& positionA = store.positions[constraint.a];
+    Vector3& positionB = store.positions[constraint.b];
+    const Vector3& sizeA = store.sizes[constraint.a];
+    const Vector3& sizeB = store.sizes[constraint.b];
+
+    const float penetration = constraint.normalX != 0
+        ? fminf(positionA.x + sizeA.x, positionB.x + sizeB.x) - fmaxf(positionA.x, positionB.x)
+        : fminf(positionA.y + sizeA.y, positionB.y + sizeB.y) - fmaxf(positionA.y, positionB.y);
+
+    const float correction = POSITION_CORRECTION * (penetration - PENETRATION_SLOP) * constraint.normalMass;
+    if (correction <= 0)
+        return;
+
+    const float inverseMassA = inverseMasses[constraint.a];
+    const float inverseMassB = inverseMasses[constraint.b];
+    if (inverseMassA != 0)
+    {
+        positionA.x -= constraint.normalX * correction * inverseMassA;
+        positionA.y -= constraint.normalY * correction * inverseMassA;
+    }
+    if (inverseMassB != 0)
+    {
+        positionB.x += constraint.normalX * correction * inverseMassB;
+        positionB.y += constraint.normalY * correction * inverseMassB;
+    }
+}
@@ -1,33 +1,84 @@
+#include "strictmath.h"
 #include "entity.h"
+#include "entitystore.h"
+#include "renderer.h"
 
-Entity::Entity(Vector3 startPos, Vector3 startSize, Color startColor)
+Entity::Entity(EntityStore* store, size_t index) : store(store), index(index) {}
+
+Vector3& Entity::Position() const
+{
+    return store->positions[index];
+}
+
+Vector3& Entity::Velocity() const
+{
+    return store->velocities[index];
+}
+
+Vector3& Entity::Size() const
+{
+    return store->sizes[index];
+}
+
+float& Entity::Friction() const
+{
+    return store->frictions[index];
+}
+
+float& Entity::Mass() const
 {
-    position = startPos;
-    size = startSize;
-    color = startColor; 
-    velocity = {0,0,0};
+    return store->masses[index];
 }
 
-void Entity::Update(float deltaTime)
+float& Entity::Restitution() const
 {
-    position.x += velocity.x * deltaTime;
-    position.y += velocity.y * deltaTime;
-    position.z += velocity.z * deltaTime;
+    return store->restitutions[index];
+}
 
-    // friction
-    velocity.x *= friction;
-    velocity.y *= friction;
-    velocity.z *= friction;
+Color& Entity::Tint() const
+{
+    return store->colors[index];
 }
 
-void Entity::AddForce(Vector3 force)
+uint32_t& Entity::Tags() const
 {
+    return store->tags[index];
+}
+
+bool Entity::IsValid() const
+{
+    return store != nullptr && index != EntityStore::INVALID_INDEX;
+}
+
+size_t Entity::GetIndex() const
+{
+    return index;
+}
+
+EntityId Entity::GetId() const
+{
+    return store->ids[index];
+}
+
+void Entity::AddForce(Vector3 force) const
+{
+    if (force.x != 0 || force.y != 0 || force.z != 0)
+        Wake();
+
+    Vector3& velocity = Velocity();
     velocity.x += force.x;
     velocity.y += force.y;
     velocity.z += force.z;
 }
 
-void Entity::Draw() const
+void Entity::Wake() const
+{
+    store->Wake(index);
+}
+
+void Entity::Draw(Renderer& renderer) const
 {
-    DrawRectangle(position.x, position.y, size.x, size.y, color);
+    const Vector3& position = Position();
+    const Vector3& size = Size();
+    renderer.DrawRectangle({position.x, position.y, size.x, size.y}, Tint());
 }
@@ -0,0 +1,498 @@
+#include "strictmath.h"
+#include "entitystore.h"
+#include <cmath>
+#include <cstring>
+#include "integrator.h"
+#include "jobsystem.h"
+
+// Slot rows that aren't rows: spawned and waiting for the next Flush, or
+// not in use (on its pool's free list)
+static const uint32_t PENDING_ROW = UINT32_MAX;
+static const uint32_t FREE_ROW = UINT32_MAX - 1;
+
+// Friction is defined as the fraction of velocity kept per step at this rate
+static const float FRICTION_RATE = 60.0f;
+
+// Smallest batch of rows worth handing to another thread
+static const size_t INTEGRATE_CHUNK = 4096;
+// Fraction of its smallest side a body may move in one substep
+static const float MAX_STEP_TRAVEL = 0.5f;
+// Substep counts are kept per row in a byte
+static const uint32_t MAX_SUBSTEPS = 64;
+
+// The columns are handed to the integrator as flat float arrays
+static_assert(sizeof(Vector3) == 3 * sizeof(float), "Vector3 must be tightly packed");
+
+EntityStore::EntityStore()
+{
+    // Default pool, grows on demand
+    pools.push_back({0, {}});
+}
+
+uint8_t EntityStore::CreatePool(uint32_t capacity)
+{
+    if (pools.size() >= MAX_POOLS)
+        return INVALID_POOL;
+
+    // The slab goes after any slots handed out since the last Flush
+    AddNewSlots();
+
+    const uint8_t pool = (uint8_t)pools.size();
+    pools.push_back({capacity, {}});
+
+    // Carve out the pool's slab of slots. The free list is filled back to
+    // front so slots are handed out in ascending order
+    const uint32_t first = (uint32_t)slots.size();
+    slots.resize(first + capacity, {FREE_ROW, 0, pool});
+    pools[pool].freeSlots.reserve(capacity);
+    for (uint32_t i = capacity; i > 0; --i)
+        pools[pool].freeSlots.push_back(first + i - 1);
+
+    ReserveRows(capacity);
+    return pool;
+}
+
+uint32_t EntityStore::FreeInPool(uint8_t pool) const
+{
+    if (pool >= pools.size())
+        return 0;
+    if (pools[pool].capacity == 0)
+        return UINT32_MAX;
+    std::lock_guard<std::mutex> lock(spawnMutex);
+    return (uint32_t)pools[pool].freeSlots.size();
+}
+
+void EntityStore::ReserveRows(size_t count)
+{
+    const size_t capacity = positions.capacity() + count;
+
+    positions.reserve(capacity);
+    previousPositions.reserve(capacity);
+    velocities.reserve(capacity);
+    sizes.reserve(capacity);
+    frictions.reserve(capacity);
+    masses.reserve(capacity);
+    restitutions.reserve(capacity);
+    colors.reserve(capacity);
+    tags.reserve(capacity);
+    flags.reserve(capacity);
+    collisionLayers.reserve(capacity);
+    collisionMasks.reserve(capacity);
+    restTimes.reserve(capacity);
+    sleeping.reserve(capacity);
+    ids.reserve(capacity);
+    dead.reserve(capacity);
+    damping.reserve(capacity);
+    pendingSpawns.reserve(capacity);
+}
+
+void EntityStore::ReleaseSlot(uint32_t slot)
+{
+    slots[slot].row = FREE_ROW;
+    pools[slots[slot].pool].freeSlots.push_back(slot);
+}
+
+void EntityStore::AddNewSlots()
+{
+    const uint32_t first = (uint32_t)slots.size();
+    for (uint32_t i = 0; i < (uint32_t)newSlots.size(); ++i)
+    {
+        // Destroyed before it was ever added, the handle is already stale
+        const uint32_t generation = newSlots[i] ? 1 : 0;
+        slots.push_back({PENDING_ROW, generation, 0});
+        if (newSlots[i])
+            ReleaseSlot(first + i);
+    }
+    newSlots.clear();
+}
+
+EntityId EntityStore::Spawn(const EntityDesc& desc)
+{
+    if (desc.pool >= pools.size())
+        return {};
+
+    std::lock_guard<std::mutex> lock(spawnMutex);
+    Pool& pool = pools[desc.pool];
+
+    // Reuse a free slot if there is one, its generation was bumped on removal
+    EntityId id;
+    if (!pool.freeSlots.empty())
+    {
+        id.index = pool.freeSlots.back();
+        id.generation = slots[id.index].generation;
+        pool.freeSlots.pop_back();
+        slots[id.index].row = PENDING_ROW;
+    }
+    else if (pool.capacity == 0)
+    {
+        // Added to slots by the next Flush
+        id.index = (uint32_t)(slots.size() + newSlots.size());
+        id.generation = 0;
+        newSlots.push_back(0);
+    }
+    else
+    {
+        return {}; // pool exhausted
+    }
+
+    pendingSpawns.push_back({id, desc});
+    return id;
+}
+
+bool EntityStore::Destroy(EntityId id)
+{
+    if (!IsAlive(id))
+        return false;
+
+    // Still waiting to be added, just drop it from the queue
+    if (id.index >= slots.size() || slots[id.index].row == PENDING_ROW)
+    {
+        std::lock_guard<std::mutex> lock(spawnMutex);
+        for (size_t i = 0; i < pendingSpawns.size(); ++i)
+        {
+            if (pendingSpawns[i].id == id)
+            {
+                pendingSpawns[i] = pendingSpawns.back();
+                pendingSpawns.pop_back();
+                break;
+            }
+        }
+
+        if (id.index >= slots.size())
+        {
+            newSlots[id.index - slots.size()] = 1;
+        }
+        else
+        {
+            slots[id.index].generation++;
+            ReleaseSlot(id.index);
+        }
+        return true;
+    }
+
+    DestroyAt(slots[id.index].row);
+    return true;
+}
+
+void EntityStore::DestroyAt(size_t index)
+{
+    if (dead[index])
+        return;
+
+    dead[index] = 1;
+    deadCount++;
+
+    // Invalidate handles now; the slot itself is recycled on Flush
+    slots[ids[index].index].generation++;
+}
+
+void EntityStore::Flush()
+{
+    // Single compaction pass over every column
+    if (deadCount > 0)
+    {
+        const size_t count = positions.size();
+        size_t write = 0;
+        for (size_t read = 0; read < count; ++read)
+        {
+            if (dead[read])
+            {
+                ReleaseSlot(ids[read].index);
+                continue;
+            }
+
+            if (write != read)
+            {
+                positions[write] = positions[read];
+                previousPositions[write] = previousPositions[read];
+                velocities[write] = velocities[read];
+                sizes[write] = sizes[read];
+                frictions[write] = frictions[read];
+                masses[write] = masses[read];
+                restitutions[write] = restitutions[read];
+                colors[write] = colors[read];
+                tags[write] = tags[read];
+                flags[write] = flags[read];
+                collisionLayers[write] = collisionLayers[read];
+                collisionMasks[write] = collisionMasks[read];
+                restTimes[write] = restTimes[read];
+                sleeping[write] = sleeping[read];
+                ids[write] = ids[read];
+                slots[ids[write].index].row = (uint32_t)write;
+            }
+            ++write;
+        }
+
+        positions.resize(write);
+        previousPositions.resize(write);
+        velocities.resize(write);
+        sizes.resize(write);
+        frictions.resize(write);
+        masses.resize(write);
+        restitutions.resize(write);
+        colors.resize(write);
+        tags.resize(write);
+        flags.resize(write);
+        collisionLayers.resize(write);
+        collisionMasks.resize(write);
+        restTimes.resize(write);
+        sleeping.resize(write);
+        ids.resize(write);
+        dead.assign(write, 0); // within capacity, no reallocation
+        deadCount = 0;
+    }
+
+    // Append everything spawned since the last flush
+    AddNewSlots();
+    for (const PendingSpawn& spawn : pendingSpawns)
+    {
+        slots[spawn.id.index].row = (uint32_t)positions.size();
+
+        positions.push_back(spawn.desc.position);
+        previousPositions.push_back(spawn.desc.position);
+        velocities.push_back(spawn.desc.velocity);
+        sizes.push_back(spawn.desc.size);
+        frictions.push_back(spawn.desc.friction);
+        masses.push_back(spawn.desc.mass);
+        restitutions.push_back(spawn.desc.restitution);
+        colors.push_back(spawn.desc.color);
+        tags.push_back(spawn.desc.tags);
+        flags.push_back(spawn.desc.flags);
+        collisionLayers.push_back(spawn.desc.collisionLayer);
+        collisionMasks.push_back(spawn.desc.collisionMask);
+        restTimes.push_back(0.0f);
+        sleeping.push_back(0);
+        ids.push_back(spawn.id);
+        dead.push_back(0);
+    }
+    pendingSpawns.clear();
+}
+
+void EntityStore::Clear()
+{
+    AddNewSlots();
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+        if (!dead[i])
+            slots[ids[i].index].generation++;
+        ReleaseSlot(ids[i].index);
+    }
+    for (const PendingSpawn& spawn : pendingSpawns)
+    {
+        slots[spawn.id.index].generation++;
+        ReleaseSlot(spawn.id.index);
+    }
+
+    positions.clear();
+    previousPositions.clear();
+    velocities.clear();
+    sizes.clear();
+    frictions.clear();
+    masses.clear();
+    restitutions.clear();
+    colors.clear();
+    tags.clear();
+    flags.clear();
+    collisionLayers.clear();
+    collisionMasks.clear();
+    restTimes.clear();
+    sleeping.clear();
+    ids.clear();
+    dead.clear();
+    deadCount = 0;
+    pendingSpawns.clear();
+}
+
+bool EntityStore::IsAlive(EntityId id) const
+{
+    if (id.index < slots.size())
+    {
+        // A free slot, or a row destroyed since the last Flush, can still
+        // match a made-up handle's generation
+        const Slot& slot = slots[id.index];
+        if (slot.generation != id.generation || slot.row == FREE_ROW)
+            return false;
+        return slot.row == PENDING_ROW || !dead[slot.row];
+    }
+
+    // Spawned since the last Flush into a slot that isn't in the table yet
+    std::lock_guard<std::mutex> lock(spawnMutex);
+    const size_t newSlot = id.index - slots.size();
+    return id.generation == 0 && newSlot < newSlots.size() && !newSlots[newSlot];
+}
+
+size_t EntityStore::IndexOf(EntityId id) const
+{
+    if (id.index >= slots.size())
+        return INVALID_INDEX;
+    const Slot& slot = slots[id.index];
+    if (slot.generation != id.generation || slot.row == PENDING_ROW || slot.row == FREE_ROW || dead[slot.row])
+        return INVALID_INDEX;
+    return slot.row;
+}
+
+size_t EntityStore::Count() const
+{
+    return positions.size();
+}
+
+bool EntityStore::IsRowAlive(size_t index) const
+{
+    return !dead[index];
+}
+
+void EntityStore::SavePreviousPositions()
+{
+    previousPositions = positions; // same size, so no reallocation
+}
+
+void EntityStore::Sleep(size_t index)
+{
+    sleeping[index] = 1;
+    velocities[index] = {0, 0, 0};
+}
+
+void EntityStore::Wake(size_t index)
+{
+    sleeping[index] = 0;
+    restTimes[index] = 0.0f;
+}
+
+bool EntityStore::IsRowActive(size_t index) const
+{
+    return !sleeping[index] && !(flags[index] & ENTITY_STATIC);
+}
+
+// FNV-1a over 32-bit words, floats by their bit pattern
+static uint64_t HashWords(uint64_t hash, const void* data, size_t words)
+{
+    const unsigned char* bytes = (const unsigned char*)data;
+    for (size_t i = 0; i < words; ++i)
+    {
+        uint32_t word;
+        memcpy(&word, bytes + i * 4, 4);
+        hash = (hash ^ word) * 1099511628211ull;
+    }
+    return hash;
+}
+
+uint64_t EntityStore::ComputeHash() const
+{
+    uint64_t hash = 14695981039346656037ull;
+    const uint32_t count = (uint32_t)positions.size();
+    hash = HashWords(hash, &count, 1);
+
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        const uint32_t state[2] = { flags[i], sleeping[i] };
+        hash = HashWords(hash, &ids[i], 2);
+        hash = HashWords(hash, &positions[i], 3);
+        hash = HashWords(hash, &velocities[i], 3);
+        hash = HashWords(hash, &sizes[i], 3);
+        hash = HashWords(hash, &restTimes[i], 1);
+        hash = HashWords(hash, state, 2);
+    }
+    return hash;
+}
+
+void EntityStore::Integrate(float dt)
+{
+    IntegrateSubstep(dt, 0, 1);
+}
+
+SubstepPlan EntityStore::PlanSubsteps(float dt, uint32_t maxSubsteps)
+{
+    // Largest power of two within the cap, the row counts are stored in bytes
+    uint32_t cap = 1;
+    while (cap * 2 <= maxSubsteps && cap * 2 <= MAX_SUBSTEPS)
+        cap *= 2;
+
+    SubstepPlan plan;
+    substeps.assign(positions.size(), 1);
+    for (size_t i = 0; i < positions.size(); ++i)
+    {
+        if (!IsRowActive(i))
+            continue;
+        ++plan.rowSteps;
+        if (cap == 1 || (flags[i] & (ENTITY_BULLET | ENTITY_TRIGGER | ENTITY_NO_COLLISION)))
+            continue;
+
+        const Vector3& velocity = velocities[i];
+        const Vector3& size = sizes[i];
+        const float extent = fminf(size.x, size.y) * MAX_STEP_TRAVEL;
+        const float travel = (fabsf(velocity.x) + fabsf(velocity.y)) * dt;
+        if (travel <= extent)
+            continue;
+
+        uint32_t steps = 1;
+        while (steps < cap && travel > extent * steps)
+            steps *= 2;
+
+        substeps[i] = (uint8_t)steps;
+        ++plan.substeppedRows;
+        plan.rowSteps += steps - 1;
+        if (steps > plan.count)
+            plan.count = steps;
+    }
+    return plan;
+}
+
+void EntityStore::IntegrateSubstep(float dt, uint32_t substep, uint32_t count)
+{
+    damping.resize(positions.size());
+
+    // Rows are independent, so chunks go to the job system. Results don't
+    // depend on how the rows are split
+    JobSystem::ParallelFor(positions.size(), INTEGRATE_CHUNK, [this, dt, substep, count](size_t begin, size_t end)
+    {
+        IntegrateRange(begin, end, dt, substep, count);
+    });
+}
+
+void EntityStore::IntegrateRange(size_t begin, size_t end, float dt, uint32_t substep, uint32_t count)
+{
+    // Rows taking k steps this tick move by dt / k, and only on their substeps
+    auto rowSteps = [&](size_t i) -> uint32_t
+    {
+        if (!IsRowActive(i))
+            return 0;
+        const uint32_t steps = count > 1 ? substeps[i] : 1;
+        return substep % (count / steps) == 0 ? steps : 0;
+    };
+
+    // Per-row damping for its step, with StrictMath::Pow so it doesn't
+    // depend on the C runtime. Rows of the same kind share a friction value
+    // and step, so only recompute it when those change
+    float lastFriction = 1.0f;
+    uint32_t lastSteps = 1;
+    float lastDamping = 1.0f;
+    for (size_t i = begin; i < end; ++i)
+    {
+        const uint32_t steps = count > 1 ? substeps[i] : 1;
+        if (frictions[i] != lastFriction || steps != lastSteps)
+        {
+            lastFriction = frictions[i];
+            lastSteps = steps;
+            lastDamping = StrictMath::Pow(lastFriction, dt / steps * FRICTION_RATE);
+        }
+        damping[i] = lastDamping;
+    }
+
+    // Hand the kernel each run of rows moving this substep by the same
+    // step, skipping sleeping and static ones
+    size_t i = begin;
+    while (i < end)
+    {
+        while (i < end && rowSteps(i) == 0)
+            ++i;
+        if (i == end)
+            break;
+
+        const size_t runBegin = i;
+        const uint32_t steps = rowSteps(i);
+        while (i < end && rowSteps(i) == steps)
+            ++i;
+
+        Integrator::IntegrateBatch(&positions[runBegin].x, &velocities[runBegin].x, damping.data() + runBegin, i - runBegin, dt / steps);
+    }
+}
@@ -1,59 +1,374 @@
+#include "strictmath.h"
 #include "game.h"
+#include <algorithm>
+#include <tuple>
 #include "entity.h"
 #include "settings.h"
 #include "console.h"
+#include "integrator.h"
 
-Game::Game(Settings& settings) : settings(&settings) {}  // store pointer to settings
+Game::Game(Settings& settings)
+    : particles((uint32_t)settings.simulation.maxParticles)
+    , renderer(settings.video.headless ? (Renderer*)new NullRenderer({(float)settings.video.windowWidth, (float)settings.video.windowHeight}) : new RaylibRenderer())
+    , broadphase(settings.simulation.broadphase == "sap" ? (Broadphase*)new SweepAndPrune() : new SpatialHashGrid())
+    , settings(&settings)  // store pointer to settings
+{
+    // SIMD kernels match the scalar one bit for bit, but deterministic runs
+    // pin the scalar path so nothing depends on the host CPU
+    if (settings.simulation.deterministic)
+    {
+        Integrator::SetPath(Integrator::Path::Scalar);
+#ifdef TT_FAST_MATH
+        Console::PrintLine("Warning: built with fast math, deterministic runs may not reproduce");
+#endif
+    }
+
+    contactManager.SetIterations(settings.simulation.solverIterations);
+    narrowphase.SetDeterministic(settings.simulation.deterministic);
+    contactManager.SetDeterministic(settings.simulation.deterministic);
+    systems.SetDeterministic(settings.simulation.deterministic);
+    islands.SetSleepTime(settings.simulation.sleepTime);
+
+    Console::PrintLine(std::string("Integrator: ") + Integrator::GetPathName(Integrator::GetPath()));
+    Console::PrintLine(std::string("Broadphase: ") + (settings.simulation.broadphase == "sap" ? "sweep and prune" : "spatial hash"));
+}
 
 Game::~Game() 
 {
-    for (Entity* entity : entities) 
+    entities.Clear();
+}
+
+void Game::Update(float dt) 
+{
+    // Apply whatever was spawned or removed since the last update
+    entities.Flush();
+
+    entities.SavePreviousPositions();
+
+    // Bodies fast for their size take several smaller steps, everything
+    // else one. Collisions are found and solved after every substep
+    const SubstepPlan plan = entities.PlanSubsteps(dt, (uint32_t)settings->simulation.maxSubsteps);
+    if (plan.count > 1)
+        tickStart = entities.previousPositions;
+
+    collisions.clear();
+    contacts.clear();
+    triggerOverlaps.clear();
+    tileCollisions.clear();
+    for (uint32_t substep = 0; substep < plan.count; ++substep) 
+    {
+        // Sweeps (bullets, walls) start where this substep starts
+        if (substep > 0)
+            entities.SavePreviousPositions();
+        entities.IntegrateSubstep(dt, substep, plan.count);
+        if (substep == 0) 
+        {
+            particles.Update(dt);
+            CullOffscreen();
+        }
+
+        DetectCollisions();
+        // Push touching bodies apart, the new velocities apply from the next step
+        contactManager.Update(entities, narrowphase.GetOverlaps());
+        CollideWithTiles();
+    }
+
+    if (plan.count > 1) 
     {
-        delete entity;
+        // Interpolation and the spatial index work from the start of the tick
+        entities.previousPositions.swap(tickStart);
+        RemoveDuplicateCollisions();
     }
-    entities.clear();
+
+    // A body that went through a trigger in an earlier substep still enters it
+    triggers.Update(entities, triggerOverlaps);
+    // Sleep or wake bodies by island, sleeping ones skip the next Integrate
+    islands.Update(entities, contacts, dt);
+    UpdateSpatialIndex();
+
+    stats.substeps = plan.count;
+    stats.substeppedBodies = plan.substeppedRows;
+    stats.bodySteps = plan.rowSteps;
+    stats.contacts = contactManager.GetContactCount();
+    stats.islands = islands.GetIslandCount();
+
+    // Gameplay systems, spawns and removals they request are deferred
+    systems.Run(dt);
+
+    // Compact once for everything destroyed during this update
+    entities.Flush();
+
+    if (settings->simulation.deterministic)
+        stateHash = entities.ComputeHash();
 }
 
-void Game::Update(float dt) 
+void Game::CullOffscreen() 
 {
-    for (Entity* entity : entities) 
+    // delete if off-screen drastically (temporary)
+    const Vector2 viewport = GetViewportSize();
+    const float screenW = viewport.x;
+    const float screenH = viewport.y;
+    for (size_t i = 0; i < entities.Count(); ++i) 
     {
-        entity->Update(dt);
-        // delete if off-screen drastically (temporary)
-        if (entity->position.x < -GetScreenWidth() || entity->position.x > GetScreenWidth() * 2 ||
-            entity->position.y < -GetScreenHeight() || entity->position.y > GetScreenHeight() * 2) 
+        const Vector3& position = entities.positions[i];
+        if (position.x < -screenW || position.x > screenW * 2 ||
+            position.y < -screenH || position.y > screenH * 2) 
         {
-            RemoveEntity(entity);
-            delete entity;
+            entities.DestroyAt(i);
         }
     }
 }
 
-void Game::Draw() 
+// Appends to collisions, contacts and triggerOverlaps, Update clears them
+// once per tick
+void Game::DetectCollisions() 
+{
+    // Broadphase narrows the candidates, the narrowphase confirms them
+    broadphase->Update(entities);
+    narrowphase.Update(entities, broadphase->GetPairs());
+    for (const CollisionPair& pair : narrowphase.GetOverlaps()) 
+    {
+        collisions.push_back({entities.ids[pair.a], entities.ids[pair.b]});
+        contacts.push_back(pair);
+    }
+
+    // Bullets stop where they first hit something
+    for (const Impact& impact : narrowphase.GetImpacts()) 
+    {
+        const Vector3& previous = entities.previousPositions[impact.bullet];
+        Vector3& position = entities.positions[impact.bullet];
+        position.x = previous.x + (position.x - previous.x) * impact.time;
+        position.y = previous.y + (position.y - previous.y) * impact.time;
+
+        collisions.push_back({entities.ids[impact.bullet], entities.ids[impact.other]});
+        contacts.push_back({impact.bullet, impact.other});
+    }
+
+    const std::vector<CollisionPair>& triggered = narrowphase.GetTriggerOverlaps();
+    triggerOverlaps.insert(triggerOverlaps.end(), triggered.begin(), triggered.end());
+}
+
+void Game::RemoveDuplicateCollisions() 
 {
-    for (Entity* entity : entities) 
+    // Pairs touching over several substeps are reported once
+    for (Collision& collision : collisions) 
     {
-        entity->Draw();
+        if (collision.b.index < collision.a.index)
+            std::swap(collision.a, collision.b);
     }
+
+    auto key = [](const Collision& collision)
+    {
+        return std::make_tuple(collision.a.index, collision.a.generation, collision.b.index, collision.b.generation);
+    };
+    std::sort(collisions.begin(), collisions.end(), [&](const Collision& a, const Collision& b) { return key(a) < key(b); });
+    collisions.erase(std::unique(collisions.begin(), collisions.end(), [&](const Collision& a, const Collision& b) { return key(a) == key(b); }), collisions.end());
 }
 
-void Game::SpawnEntity(Entity* entity) 
+void Game::CollideWithTiles() 
 {
-    entities.push_back(entity);
+    tilemap.Collide(entities);
+
+    for (const TileHit& hit : tilemap.GetHits())
+        tileCollisions.push_back({entities.ids[hit.row], hit.x, hit.y, tilemap.GetColliders()[hit.collider], hit.normal});
 }
 
-void Game::RemoveEntity(Entity* entity) 
+void Game::UpdateSpatialIndex() 
 {
-    for (size_t i = 0; i < entities.size(); ++i) 
+    ++tick;
+
+    for (size_t i = 0; i < entities.Count(); ++i) 
+    {
+        if (!entities.IsRowAlive(i))
+            continue;
+
+        const EntityId id = entities.ids[i];
+        const Vector3& position = entities.positions[i];
+        const Vector3& size = entities.sizes[i];
+        const Rectangle bounds = { position.x, position.y, size.x, size.y };
+
+        if (id.index >= spatialProxies.size())
+            spatialProxies.resize(id.index + 1);
+
+        // Slot reused by a new entity since the last tick
+        SpatialProxy& entry = spatialProxies[id.index];
+        if (entry.proxy != AABBTree::NULL_NODE && entry.id != id) 
+        {
+            spatialIndex.DestroyProxy(entry.proxy);
+            entry.proxy = AABBTree::NULL_NODE;
+        }
+
+        if (entry.proxy == AABBTree::NULL_NODE) 
+        {
+            entry.id = id;
+            entry.proxy = spatialIndex.CreateProxy(bounds, id.index);
+        }
+        else 
+        {
+            const Vector3& previous = entities.previousPositions[i];
+            spatialIndex.MoveProxy(entry.proxy, bounds, {position.x - previous.x, position.y - previous.y});
+        }
+        entry.lastTick = tick;
+    }
+
+    // Entities that were destroyed
+    for (SpatialProxy& entry : spatialProxies) 
     {
-        if (entities[i] == entity) {
-            entities.erase(entities.begin() + i);
-            return;
+        if (entry.proxy != AABBTree::NULL_NODE && entry.lastTick != tick) 
+        {
+            spatialIndex.DestroyProxy(entry.proxy);
+            entry.proxy = AABBTree::NULL_NODE;
         }
     }
 }
 
-std::vector<Entity*> Game::GetEntities() const 
+void Game::QueryBox(const Rectangle& box, std::vector<EntityId>& results) const 
+{
+    // Tree user data is the handle slot. Straight into results, so a
+    // caller reusing its vector doesn't allocate
+    results.clear();
+    spatialIndex.Query(box, [&](uint32_t slot) { results.push_back(spatialProxies[slot].id); });
+}
+
+bool Game::Raycast(Vector2 origin, Vector2 direction, float maxDistance, RaycastHit& hit, EntityId ignore) const 
+{
+    TreeRayHit treeHit;
+    if (!spatialIndex.Raycast(origin, direction, maxDistance, treeHit, ignore.index))
+        return false;
+
+    hit.entity = spatialProxies[treeHit.userData].id;
+    hit.distance = treeHit.distance;
+    hit.point = treeHit.point;
+    hit.normal = treeHit.normal;
+    return true;
+}
+
+EntityId Game::QueryNearest(Vector2 point, float maxDistance, EntityId ignore) const 
+{
+    uint32_t slot;
+    if (!spatialIndex.QueryNearest(point, maxDistance, slot, ignore.index))
+        return EntityId();
+    return spatialProxies[slot].id;
+}
+
+void Game::Draw(float alpha) 
+{
+    // Particles are background effects, draw them under the entities
+    particles.Draw(*renderer, alpha);
+    tilemap.Draw(*renderer, DARKGRAY);
+
+    for (size_t i = 0; i < entities.Count(); ++i) 
+    {
+        const Vector3& previous = entities.previousPositions[i];
+        const Vector3& current = entities.positions[i];
+        const Vector3& size = entities.sizes[i];
+
+        // Render between ticks so motion stays smooth above the tick rate
+        float x = previous.x + (current.x - previous.x) * alpha;
+        float y = previous.y + (current.y - previous.y) * alpha;
+        renderer->DrawRectangle({x, y, size.x, size.y}, entities.colors[i]);
+    }
+}
+
+Renderer& Game::GetRenderer() 
+{
+    return *renderer;
+}
+
+void Game::SetRenderer(std::unique_ptr<Renderer> renderer) 
+{
+    this->renderer = std::move(renderer);
+}
+
+Vector2 Game::GetViewportSize() const
+{
+    return renderer->GetViewportSize();
+}
+
+void Game::RegisterSystem(const std::string& name, uint32_t reads, uint32_t writes, SystemScheduler::SystemFunction function) 
+{
+    systems.Register(name, reads, writes, function);
+}
+
+void Game::PrintSystemSchedule() 
+{
+    systems.PrintSchedule();
+}
+
+uint8_t Game::CreateEntityPool(uint32_t capacity) 
+{
+    const uint8_t pool = entities.CreatePool(capacity);
+    if (pool == EntityStore::INVALID_POOL)
+        Console::PrintLine("Warning: entity pool limit (" + std::to_string(EntityStore::MAX_POOLS) + ") reached, pool not created");
+    return pool;
+}
+
+EntityId Game::SpawnEntity(const EntityDesc& desc) 
+{
+    return entities.Spawn(desc);
+}
+
+void Game::RemoveEntity(EntityId id) 
+{
+    entities.Destroy(id);
+}
+
+bool Game::IsAlive(EntityId id) const
+{
+    return entities.IsAlive(id);
+}
+
+Entity Game::GetEntity(EntityId id) 
+{
+    return Entity(&entities, entities.IndexOf(id));
+}
+
+ParticleSystem& Game::GetParticles() 
+{
+    return particles;
+}
+
+const std::vector<Collision>& Game::GetCollisions() const 
+{
+    return collisions;
+}
+
+const std::vector<TriggerEvent>& Game::GetTriggerEvents() const 
+{
+    return triggers.GetEvents();
+}
+
+bool Game::IsInTrigger(EntityId trigger, EntityId other) const 
+{
+    return triggers.IsInside(trigger, other);
+}
+
+TileMap& Game::GetTileMap() 
+{
+    return tilemap;
+}
+
+const std::vector<TileCollision>& Game::GetTileCollisions() const 
+{
+    return tileCollisions;
+}
+
+const PhysicsStats& Game::GetPhysicsStats() const
+{
+    return stats;
+}
+
+uint32_t Game::GetTick() const
+{
+    return tick;
+}
+
+uint64_t Game::GetStateHash() const
+{
+    return stateHash;
+}
+
+EntityRange Game::GetEntities() 
 {
-    return entities;
+    return EntityRange(&entities);
 }
@@ -0,0 +1,174 @@
+#include "strictmath.h"
+#include "integrator.h"
+#include "simd.h"
+
+namespace Integrator
+{
+    static Path activePath = DetectPath();
+
+    Path DetectPath()
+    {
+#if defined(TT_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        const int maxLeaf = info[0];
+
+        __cpuid(info, 1);
+        const bool sse2 = (info[3] & (1 << 26)) != 0;
+        const bool osxsave = (info[2] & (1 << 27)) != 0;
+        const bool avx = (info[2] & (1 << 28)) != 0;
+
+        bool avx2 = false;
+        if (maxLeaf >= 7 && osxsave && avx)
+        {
+            // OS must save the YMM registers on context switch
+            const unsigned long long xcr0 = _xgetbv(0);
+            if ((xcr0 & 0x6) == 0x6)
+            {
+                __cpuidex(info, 7, 0);
+                avx2 = (info[1] & (1 << 5)) != 0;
+            }
+        }
+
+        if (avx2) return Path::AVX2;
+        if (sse2) return Path::SSE2;
+        return Path::Scalar;
+#elif defined(TT_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return Path::AVX2;
+        if (__builtin_cpu_supports("sse2")) return Path::SSE2;
+        return Path::Scalar;
+#else
+        return Path::Scalar;
+#endif
+    }
+
+    Path GetPath()
+    {
+        return activePath;
+    }
+
+    void SetPath(Path path)
+    {
+        const Path best = DetectPath();
+        activePath = (int)path <= (int)best ? path : best;
+    }
+
+    const char* GetPathName(Path path)
+    {
+        switch (path)
+        {
+            case Path::AVX2: return "AVX2";
+            case Path::SSE2: return "SSE2";
+            default:         return "Scalar";
+        }
+    }
+
+    void IntegrateBatch(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        switch (activePath)
+        {
+            case Path::AVX2: IntegrateAVX2(positions, velocities, damping, count, dt); break;
+            case Path::SSE2: IntegrateSSE2(positions, velocities, damping, count, dt); break;
+            default:         IntegrateScalar(positions, velocities, damping, count, dt); break;
+        }
+    }
+
+    void IntegrateScalar(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            float* p = positions + i * 3;
+            float* v = velocities + i * 3;
+            const float d = damping[i];
+
+            // Separate multiply and add on purpose, matches the SIMD paths
+            const float dx = v[0] * dt;
+            const float dy = v[1] * dt;
+            const float dz = v[2] * dt;
+            p[0] += dx;
+            p[1] += dy;
+            p[2] += dz;
+
+            v[0] *= d;
+            v[1] *= d;
+            v[2] *= d;
+        }
+    }
+
+#ifdef TT_X86
+    void IntegrateSSE2(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        const __m128 step = _mm_set1_ps(dt);
+        size_t i = 0;
+
+        // 4 entities = 12 floats = 3 registers per column
+        for (; i + 4 <= count; i += 4)
+        {
+            float* p = positions + i * 3;
+            float* v = velocities + i * 3;
+
+            __m128 v0 = _mm_loadu_ps(v);
+            __m128 v1 = _mm_loadu_ps(v + 4);
+            __m128 v2 = _mm_loadu_ps(v + 8);
+
+            _mm_storeu_ps(p,     _mm_add_ps(_mm_loadu_ps(p),     _mm_mul_ps(v0, step)));
+            _mm_storeu_ps(p + 4, _mm_add_ps(_mm_loadu_ps(p + 4), _mm_mul_ps(v1, step)));
+            _mm_storeu_ps(p + 8, _mm_add_ps(_mm_loadu_ps(p + 8), _mm_mul_ps(v2, step)));
+
+            // Spread d0..d3 over the xyz triples: [d0 d0 d0 d1] [d1 d1 d2 d2] [d2 d3 d3 d3]
+            const __m128 d = _mm_loadu_ps(damping + i);
+            const __m128 d0 = _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 0, 0));
+            const __m128 d1 = _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 2, 1, 1));
+            const __m128 d2 = _mm_shuffle_ps(d, d, _MM_SHUFFLE(3, 3, 3, 2));
+
+            _mm_storeu_ps(v,     _mm_mul_ps(v0, d0));
+            _mm_storeu_ps(v + 4, _mm_mul_ps(v1, d1));
+            _mm_storeu_ps(v + 8, _mm_mul_ps(v2, d2));
+        }
+
+        IntegrateScalar(positions + i * 3, velocities + i * 3, damping + i, count - i, dt);
+    }
+
+    TT_TARGET_AVX2 void IntegrateAVX2(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        const __m256 step = _mm256_set1_ps(dt);
+        const __m256i spread0 = _mm256_setr_epi32(0, 0, 0, 1, 1, 1, 2, 2);
+        const __m256i spread1 = _mm256_setr_epi32(2, 3, 3, 3, 4, 4, 4, 5);
+        const __m256i spread2 = _mm256_setr_epi32(5, 5, 6, 6, 6, 7, 7, 7);
+        size_t i = 0;
+
+        // 8 entities = 24 floats = 3 registers per column
+        for (; i + 8 <= count; i += 8)
+        {
+            float* p = positions + i * 3;
+            float* v = velocities + i * 3;
+
+            __m256 v0 = _mm256_loadu_ps(v);
+            __m256 v1 = _mm256_loadu_ps(v + 8);
+            __m256 v2 = _mm256_loadu_ps(v + 16);
+
+            _mm256_storeu_ps(p,      _mm256_add_ps(_mm256_loadu_ps(p),      _mm256_mul_ps(v0, step)));
+            _mm256_storeu_ps(p + 8,  _mm256_add_ps(_mm256_loadu_ps(p + 8),  _mm256_mul_ps(v1, step)));
+            _mm256_storeu_ps(p + 16, _mm256_add_ps(_mm256_loadu_ps(p + 16), _mm256_mul_ps(v2, step)));
+
+            const __m256 d = _mm256_loadu_ps(damping + i);
+            _mm256_storeu_ps(v,      _mm256_mul_ps(v0, _mm256_permutevar8x32_ps(d, spread0)));
+            _mm256_storeu_ps(v + 8,  _mm256_mul_ps(v1, _mm256_permutevar8x32_ps(d, spread1)));
+            _mm256_storeu_ps(v + 16, _mm256_mul_ps(v2, _mm256_permutevar8x32_ps(d, spread2)));
+        }
+
+        IntegrateScalar(positions + i * 3, velocities + i * 3, damping + i, count - i, dt);
+    }
+#else
+    void IntegrateSSE2(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        IntegrateScalar(positions, velocities, damping, count, dt);
+    }
+
+    void IntegrateAVX2(float* positions, float* velocities, const float* damping, size_t count, float dt)
+    {
+        IntegrateScalar(positions, velocities, damping, count, dt);
+    }
+#endif
+}
@@ -0,0 +1,136 @@
+#include "strictmath.h"
+#include "islands.h"
+#include <cfloat>
+
+// Speed below which a body counts as at rest, world units per second
+static const float REST_SPEED = 2.0f;
+
+static const uint32_t NO_ISLAND = UINT32_MAX;
+
+void IslandManager::SetSleepTime(float seconds)
+{
+    sleepTime = seconds > 0 ? seconds : 0;
+}
+
+float IslandManager::GetSleepTime() const
+{
+    return sleepTime;
+}
+
+size_t IslandManager::GetIslandCount() const
+{
+    return offsets.empty() ? 0 : offsets.size() - 1;
+}
+
+uint32_t IslandManager::Find(uint32_t row)
+{
+    // Path halving keeps the trees flat without recursion
+    while (parent[row] != row)
+    {
+        parent[row] = parent[parent[row]];
+        row = parent[row];
+    }
+    return row;
+}
+
+void IslandManager::Union(uint32_t a, uint32_t b)
+{
+    a = Find(a);
+    b = Find(b);
+    if (a != b)
+        parent[a] = b;
+}
+
+void IslandManager::Update(EntityStore& store, const std::vector<CollisionPair>& contacts, float dt)
+{
+    const size_t rows = store.Count();
+
+    // How long each awake body has been nearly still
+    for (size_t i = 0; i < rows; ++i)
+    {
+        if (!store.IsRowActive(i))
+            continue;
+
+        const Vector3& v = store.velocities[i];
+        if (v.x * v.x + v.y * v.y + v.z * v.z < REST_SPEED * REST_SPEED)
+            store.restTimes[i] += dt;
+        else
+            store.restTimes[i] = 0.0f;
+    }
+
+    parent.resize(rows);
+    for (uint32_t i = 0; i < rows; ++i)
+        parent[i] = i;
+    touched.assign(rows, 0);
+
+    for (const CollisionPair& contact : contacts)
+    {
+        if ((store.flags[contact.a] | store.flags[contact.b]) & ENTITY_STATIC)
+            continue;
+
+        touched[contact.a] = 1;
+        touched[contact.b] = 1;
+        Union(contact.a, contact.b);
+    }
+
+    // Bodies taking part this tick: awake ones and sleeping ones something
+    // touched. islandIndex holds each member's root for now
+    islandIndex.assign(rows, NO_ISLAND);
+    islandRest.assign(rows, FLT_MAX);
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        if (!store.IsRowAlive(i) || (store.flags[i] & ENTITY_STATIC) || (store.sleeping[i] && !touched[i]))
+            continue;
+
+        // An island is as rested as its least rested body. Sleeping bodies
+        // kept the rest time they fell asleep with
+        const uint32_t root = Find(i);
+        islandIndex[i] = root;
+        if (store.restTimes[i] < islandRest[root])
+            islandRest[root] = store.restTimes[i];
+    }
+
+    // Sleep or wake each island as a whole
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        if (islandIndex[i] == NO_ISLAND)
+            continue;
+
+        const bool rested = sleepTime > 0 && islandRest[islandIndex[i]] >= sleepTime;
+        if (rested && !store.sleeping[i])
+            store.Sleep(i);
+        else if (!rested && store.sleeping[i])
+            store.Wake(i);
+    }
+
+    // Bucket the members by island, numbering islands in order of their root
+    offsets.assign(1, 0);
+    rootIsland.assign(rows, NO_ISLAND);
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        if (islandRest[i] != FLT_MAX)
+        {
+            rootIsland[i] = (uint32_t)offsets.size() - 1;
+            offsets.push_back(0);
+        }
+    }
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        if (islandIndex[i] != NO_ISLAND)
+        {
+            islandIndex[i] = rootIsland[islandIndex[i]];
+            ++offsets[islandIndex[i] + 1];
+        }
+    }
+    for (size_t i = 1; i < offsets.size(); ++i)
+        offsets[i] += offsets[i - 1];
+
+    // parent is free again, use it as the fill cursor per island
+    bodies.resize(offsets.back());
+    parent.assign(offsets.begin(), offsets.end() - 1);
+    for (uint32_t i = 0; i < rows; ++i)
+    {
+        if (islandIndex[i] != NO_ISLAND)
+            bodies[parent[islandIndex[i]]++] = i;
+    }
+}
@@ -0,0 +1,209 @@
+#include "jobsystem.h"
+#include "console.h"
+
+// Fixed-size ring per thread, so pushing and popping never allocate.
+// A full queue just runs the job inline.
+static const size_t QUEUE_CAPACITY = 1024;
+
+struct JobSystem::WorkQueue
+{
+    std::mutex lock;
+    Job jobs[QUEUE_CAPACITY];
+    size_t head = 0; // oldest job, stolen from here
+    size_t tail = 0; // newest job, owner pops from here
+
+    bool PushBack(const Job& job)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tail - head == QUEUE_CAPACITY)
+            return false;
+        jobs[tail % QUEUE_CAPACITY] = job;
+        ++tail;
+        return true;
+    }
+
+    bool PopBack(Job& job)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tail == head)
+            return false;
+        --tail;
+        job = jobs[tail % QUEUE_CAPACITY];
+        return true;
+    }
+
+    bool StealFront(Job& job)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (tail == head)
+            return false;
+        job = jobs[head % QUEUE_CAPACITY];
+        ++head;
+        return true;
+    }
+};
+
+std::vector<std::unique_ptr<JobSystem::WorkQueue>> JobSystem::queues;
+std::vector<std::thread> JobSystem::workers;
+std::atomic<bool> JobSystem::running{false};
+std::atomic<int> JobSystem::queuedJobs{0};
+std::mutex JobSystem::sleepLock;
+std::condition_variable JobSystem::wakeUp;
+
+// Which queue belongs to the current thread, 0 for the main thread
+static thread_local int threadIndex = 0;
+
+void JobSystem::Init(int workerCount)
+{
+    if (running)
+        return;
+
+    if (workerCount <= 0)
+    {
+        int cores = (int)std::thread::hardware_concurrency();
+        workerCount = cores > 1 ? cores - 1 : 0;
+    }
+
+    queues.clear();
+    for (int i = 0; i <= workerCount; ++i)
+        queues.push_back(std::make_unique<WorkQueue>());
+
+    running = true;
+    for (int i = 1; i <= workerCount; ++i)
+        workers.emplace_back(&JobSystem::WorkerLoop, i);
+
+    Console::PrintLine("Job system started with " + std::to_string(workerCount) + " workers.");
+}
+
+void JobSystem::Shutdown()
+{
+    if (!running)
+        return;
+
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        running = false;
+    }
+    wakeUp.notify_all();
+
+    for (std::thread& worker : workers)
+        worker.join();
+    workers.clear();
+    queues.clear();
+}
+
+int JobSystem::GetWorkerCount()
+{
+    return (int)workers.size();
+}
+
+void JobSystem::Run(const Job& job, JobCounter* after)
+{
+    if (job.counter)
+        job.counter->pending++;
+
+    // Hold the job back until its dependency is done. The last job of the
+    // dependency takes the lock before reading the list, so nothing is lost
+    if (after)
+    {
+        std::lock_guard<std::mutex> guard(after->lock);
+        if (!after->IsDone())
+        {
+            after->continuations.push_back(job);
+            return;
+        }
+    }
+
+    Push(job);
+}
+
+void JobSystem::Wait(JobCounter& counter)
+{
+    while (!counter.IsDone())
+    {
+        Job job;
+        if (TryGetJob(threadIndex, job))
+            Execute(job);
+        else
+            std::this_thread::yield();
+    }
+
+    // The finishing thread may still hold the lock, don't let the caller
+    // destroy the counter under it
+    std::lock_guard<std::mutex> guard(counter.lock);
+}
+
+void JobSystem::Push(const Job& job)
+{
+    if (workers.empty() || !queues[threadIndex]->PushBack(job))
+    {
+        Execute(job);
+        return;
+    }
+
+    // Take the sleep lock so a worker can't miss the wake-up between
+    // checking queuedJobs and going to sleep
+    {
+        std::lock_guard<std::mutex> guard(sleepLock);
+        queuedJobs++;
+    }
+    wakeUp.notify_one();
+}
+
+bool JobSystem::TryGetJob(int index, Job& job)
+{
+    if (queues.empty())
+        return false;
+
+    // Own work first (newest, still warm in cache), then steal the oldest
+    // job from the others
+    bool found = queues[index]->PopBack(job);
+    for (size_t i = 1; !found && i < queues.size(); ++i)
+        found = queues[(index + i) % queues.size()]->StealFront(job);
+
+    if (found)
+        queuedJobs--;
+    return found;
+}
+
+void JobSystem::Execute(const Job& job)
+{
+    job.function(job.data, job.begin, job.end);
+
+    JobCounter* counter = job.counter;
+    if (!counter)
+        return;
+
+    // Decrement under the lock: once it hits zero a waiter may free the
+    // counter, and Wait takes the lock before returning to sync with this
+    std::vector<Job> ready;
+    {
+        std::lock_guard<std::mutex> guard(counter->lock);
+        if (--counter->pending > 0)
+            return;
+        // Counter hit zero, release everything that was waiting on it
+        ready.swap(counter->continuations);
+    }
+    for (const Job& next : ready)
+        Push(next);
+}
+
+void JobSystem::WorkerLoop(int index)
+{
+    threadIndex = index;
+
+    while (true)
+    {
+        Job job;
+        if (TryGetJob(index, job))
+        {
+            Execute(job);
+            continue;
+        }
+
+        std::unique_lock<std::mutex> guard(sleepLock);
+        wakeUp.wait(guard, [] { return queuedJobs > 0 || !running; });
+        if (!running)
+            return;
+    }
+}
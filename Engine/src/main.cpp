@@ -1,4 +1,10 @@
 #define _CRT_SECURE_NO_WARNINGS
+#include "strictmath.h"
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
 #include "raylib.h"
 #include "game.h"
 #include "settings.h"
@@ -6,24 +12,87 @@
 #include "entity.h"
 #include "physics.h"
 #include "console.h"
+#include "timestep.h"
+#include "jobsystem.h"
 
-int main() 
+// Entity tags for this demo, used to filter Game::GetEntities
+enum SpaceStormTags : uint32_t
+{
+    TAG_SHIP       = 1 << 0,
+    TAG_PLAYER     = 1 << 1,
+    TAG_ENEMY      = 1 << 2,
+    TAG_PROJECTILE = 1 << 3,
+    TAG_EXIT       = 1 << 4,
+};
+
+// Collision layers, projectiles only collide with ships and sensors only
+// notice ships
+enum SpaceStormLayers : uint32_t
+{
+    LAYER_SHIP       = 1 << 0,
+    LAYER_PROJECTILE = 1 << 1,
+    LAYER_SENSOR     = 1 << 2,
+};
+
+// Game-side state shared between systems, declared to the scheduler like
+// components
+enum SpaceStormResources : uint32_t
+{
+    RESOURCE_PLAYER_FORCE = COMPONENT_USER << 0,
+    RESOURCE_ENEMY_FORCE  = COMPONENT_USER << 1,
+};
+
+// Set from SIGINT/SIGTERM so a headless server leaves its loop and shuts
+// down like a closed window
+static volatile std::sig_atomic_t stopRequested = 0;
+
+static void RequestStop(int)
+{
+    stopRequested = 1;
+}
+
+// --headless runs without a window (same as video.headless in the settings),
+// with --ticks N it stops after N ticks, simulated as fast as they can be,
+// and prints how long they took
+int main(int argc, char** argv) 
 {
     Console::PrintLine("TechTitan Engine - Space Storm Demo");
     // Load & Apply Settings
     Settings settings;
     settings.Load();
 
-    // Initialize Window
-    InitWindow(settings.video.windowWidth, settings.video.windowHeight, "Space Storm");
-    SetTargetFPS(settings.video.targetFPS);
+    long maxTicks = 0;
+    for (int i = 1; i < argc; ++i) 
+    {
+        if (strcmp(argv[i], "--headless") == 0)
+            settings.video.headless = true;
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc)
+            maxTicks = atol(argv[++i]);
+    }
+    const bool headless = settings.video.headless;
 
-    // Apply video and audio settings AFTER window/audio initialization
-    settings.ApplyVideo();
-    settings.ApplyAudio();
+    if (headless) 
+    {
+        Console::PrintLine(TextFormat("Headless, viewport %dx%d", settings.video.windowWidth, settings.video.windowHeight));
+        std::signal(SIGINT, RequestStop);
+        std::signal(SIGTERM, RequestStop);
+    }
+    else 
+    {
+        // Initialize Window
+        InitWindow(settings.video.windowWidth, settings.video.windowHeight, "Space Storm");
+        SetTargetFPS(settings.video.targetFPS);
+
+        // Apply video and audio settings AFTER window/audio initialization
+        settings.ApplyVideo();
+        settings.ApplyAudio();
+
+        // Initialize Input
+        Input::Init();
+    }
 
-    // Initialize Input
-    Input::Init();
+    // Worker threads for engine subsystems
+    JobSystem::Init(settings.simulation.workerThreads);
 
     // Register actions (these will eventually come from editor-defined input)
     Input::RegisterVector2("Move");
@@ -38,125 +107,199 @@ int main()
     // Create Game instance
     Game game(settings);
 
+    // Entity pool, sized so steady-state gameplay never allocates.
+    // Projectiles live ~1.5s each
+    uint8_t projectilePool = game.CreateEntityPool(128);
+
+    // Window size, or the virtual one when headless
+    const Vector2 viewport = game.GetViewportSize();
+
+    // Level from the editor, scaled to fill the screen height
+    Vector2 playerStart = {400, 500};
+    TileMap& level = game.GetTileMap();
+    if (level.Load("level.txt")) 
+    {
+        level.SetTileSize(viewport.y / level.GetHeight());
+        level.SetOrigin({(viewport.x - level.GetWidth() * level.GetTileSize()) * 0.5f, 0});
+        level.SetCollisionLayer(LAYER_SHIP);
+
+        int startX, startY;
+        if (level.FindTile(TILE_PLAYER, startX, startY))
+        {
+            Rectangle start = level.GetTileBounds(startX, startY);
+            playerStart = {start.x, start.y};
+        }
+
+        // Exits are triggers, reaching one is an enter event
+        for (int y = 0; y < level.GetHeight(); ++y)
+        {
+            for (int x = 0; x < level.GetWidth(); ++x)
+            {
+                if (level.GetTile(x, y) != TILE_EXIT)
+                    continue;
+                Rectangle exit = level.GetTileBounds(x, y);
+                game.SpawnEntity({{exit.x, exit.y, 0}, {exit.width, exit.height, 1}, DARKGREEN, {0, 0, 0}, 1, 0, 0, 0, TAG_EXIT, ENTITY_STATIC | ENTITY_TRIGGER, LAYER_SENSOR, LAYER_SHIP});
+            }
+        }
+    }
+
     // Spawn initial entities. for testing
-    Entity* player = new Entity({400, 500, 0}, {25,25,1}, BLUE);
-    game.SpawnEntity(player);
-    player->friction = 0.9f;
+    EntityId playerId = game.SpawnEntity({{playerStart.x, playerStart.y, 0}, {25,25,1}, BLUE, {0, 0, 0}, 0.9f, 1, 0.5f, 0, TAG_SHIP | TAG_PLAYER, 0, LAYER_SHIP, LAYER_SHIP | LAYER_PROJECTILE | LAYER_SENSOR});
 
     float shootTimer = 0.0f;
 
-    Entity* enemy = new Entity({200, 100, 0}, {25,25,1}, RED);
-    game.SpawnEntity(enemy);
-    enemy->friction = 0.95f;
+    EntityId enemyId = game.SpawnEntity({{200, 100, 0}, {25,25,1}, RED, {0, 0, 0}, 0.95f, 1, 0.5f, 0, TAG_SHIP | TAG_ENEMY, 0, LAYER_SHIP, LAYER_SHIP | LAYER_PROJECTILE | LAYER_SENSOR});
+
+    // What the enemy can see: a trigger below it, moved along with it
+    EntityId enemyViewId = game.SpawnEntity({{200, 125, 0}, {25, 25 * 32, 1}, BLANK, {0, 0, 0}, 1, 0, 0, 0, 0, ENTITY_TRIGGER, LAYER_SENSOR, LAYER_SHIP});
 
     float AITimer = 0.0f;
     float AIShootTimer = 0.0f;
 
-    bool gameStarted = false;
+    // Starfield: particles falling from just above the top of the screen,
+    // living just long enough for the slowest ones to leave the bottom
+    EmitterDesc stars;
+    stars.area = {0, -10, viewport.x, 0};
+    stars.rate = 15;
+    stars.minVelocity = {0, 150};
+    stars.maxVelocity = {0, 300};
+    stars.minLifetime = stars.maxLifetime = (viewport.y + 20) / 150.0f;
+    stars.size = 2;
+    stars.color = GRAY;
+    int starEmitter = game.GetParticles().AddEmitter(stars);
+
+    // Initial stars across the whole screen
+    game.GetParticles().Burst(starEmitter, 50, {0, 0, viewport.x, viewport.y});
+
     bool isPaused = false;
-    Console::PrintLine("Game Started!");
 
-    while (!WindowShouldClose()) 
+    // Temporary game logic for testing, run by Game::Update every tick.
+    // Each system declares what it reads and writes so the scheduler can
+    // run the ones that don't conflict in parallel. The control systems
+    // only decide on a force and shoot, Movement applies the forces, so
+    // PlayerControl and EnemyAI share a batch
+    Vector3 playerForce = {0, 0, 0};
+    Vector3 enemyForce = {0, 0, 0};
+
+    game.RegisterSystem("PlayerControl", COMPONENT_ENTITIES | COMPONENT_POSITION, RESOURCE_PLAYER_FORCE, [&](float dt)
     {
-        // Pausing
-        float dt = GetFrameTime();
-        if (Input::GetButtonPressed("Pause")) 
+        Entity player = game.GetEntity(playerId);
+
+        // Move the player based on input
+        playerForce = {Input::GetVector2("Move").x * 50, Input::GetVector2("Move").y * 50, 0};
+        // If player pressed fire, shoot
+        shootTimer += dt;
+        if (Input::GetButton("Fire") && shootTimer >= 0.35f) 
         {
-            isPaused = !isPaused;
-            if(isPaused)
-                Console::PrintLine("Game Paused.");
-            else
-                Console::PrintLine("Game Resumed.");
+            game.SpawnEntity({{player.Position().x + 10, player.Position().y - 13, 0}, {5, 10, 1}, YELLOW, {0, -750, 0}, 1, 1, 0, projectilePool, TAG_PROJECTILE, ENTITY_BULLET, LAYER_PROJECTILE, LAYER_SHIP});
+            shootTimer = 0.0f;
         }
-        if (!isPaused) 
-        {
-            game.Update(dt);
-
-            // Temporary game logic for testing
+    });
 
-            //stars effect (experimental, will be replaced with particle system eventually)
-            //Initial stars
-            if (!gameStarted)
-            {
-                for (int i = 0; i < 50; ++i) 
-                {
-                    Entity* star = new Entity({(float)GetRandomValue(0, GetScreenWidth()), (float)GetRandomValue(0, GetScreenHeight()), 0}, {2, 2, 1}, GRAY);
-                    game.SpawnEntity(star);
-                    star->AddForce({0, (float)GetRandomValue(150, 300), 0});
-                }
-                gameStarted = true;
-            }
-            
-            // Spawn new stars at the top randomly
-            if (GetRandomValue(0, 100) < 25) 
-            {
-                Entity* star = new Entity({(float)GetRandomValue(0, GetScreenWidth()), -10, 0}, {2, 2, 1}, GRAY);
-                game.SpawnEntity(star);
-                star->AddForce({0, (float)GetRandomValue(150, 300), 0});
-            }
+    game.RegisterSystem("EnemyAI", COMPONENT_ENTITIES | COMPONENT_POSITION, RESOURCE_ENEMY_FORCE, [&](float dt)
+    {
+        Entity enemy = game.GetEntity(enemyId);
 
-            // Move the player based on input
-            player->AddForce({Input::GetVector2("Move").x * 50, Input::GetVector2("Move").y * 50, 0});
-            // If player pressed fire, shoot
-            shootTimer += dt;
-            if (Input::GetButton("Fire") && shootTimer >= 0.35f) 
-            {
-                Entity* projectile = new Entity({player->position.x + 10, player->position.y - 13, 0}, {5, 10, 1}, YELLOW);
-                game.SpawnEntity(projectile);
-                projectile->AddForce({0, -750, 0});
-                shootTimer = 0.0f;
-            }
+        // Move the enemy left and right
+        AITimer += dt;
+        enemyForce = {StrictMath::Sin(AITimer) * 10, 0, 0};
+        // if enemy can see player, shoot
+        AIShootTimer += dt;
+        bool seesPlayer = game.IsInTrigger(enemyViewId, playerId);
+        if (seesPlayer && AIShootTimer >= 0.35f) 
+        {
+            game.SpawnEntity({{enemy.Position().x + 10, enemy.Position().y + 30, 0}, {5, 10, 1}, YELLOW, {0, 750, 0}, 1, 1, 0, projectilePool, TAG_PROJECTILE, ENTITY_BULLET, LAYER_PROJECTILE, LAYER_SHIP});
+            AIShootTimer = 0.0f;
+        }
+    });
 
-            // Move the enemy left and right
-            AITimer += dt;
-            enemy->AddForce({sin(AITimer) * 10, 0, 0});
-            // if enemy can see player, shoot
-            AIShootTimer += dt;
-            Rectangle enemyView = {enemy->position.x, enemy->position.y + enemy->size.y, enemy->size.x, enemy->size.y * 32};
-            if (Physics::CheckCollision(*player, enemyView) && AIShootTimer >= 0.35f) 
+    game.RegisterSystem("Collision", COMPONENT_ENTITIES | COMPONENT_TAGS, COMPONENT_ENTITIES, [&](float)
+    {
+        // Ships bouncing off each other is handled by the contact solver,
+        // only gameplay reactions are left here
+        for (const Collision& collision : game.GetCollisions()) 
+        {
+            // Projectiles are bullets, swept so they can't skip past a ship,
+            // and are used up by the first ship they hit
+            bool aIsShip = collision.a == playerId || collision.a == enemyId;
+            bool bIsShip = collision.b == playerId || collision.b == enemyId;
+            if (aIsShip != bIsShip) 
             {
-                Entity* enemy_projectile = new Entity({enemy->position.x + 10, enemy->position.y + 30, 0}, {5, 10, 1}, YELLOW);
-                game.SpawnEntity(enemy_projectile);
-                enemy_projectile->AddForce({0, 750, 0});
-                AIShootTimer = 0.0f;
+                game.RemoveEntity(aIsShip ? collision.b : collision.a);
             }
+        }
 
-            // Testing collision resolution
-            if( Physics::CheckCollision(*player, *enemy) ) 
+        for (const TriggerEvent& event : game.GetTriggerEvents()) 
+        {
+            if (event.type == TRIGGER_ENTER && event.other == playerId && game.IsAlive(event.trigger) &&
+                (game.GetEntity(event.trigger).Tags() & TAG_EXIT))
             {
-                Physics::ResolveCollision(*player, *enemy);
+                Console::PrintLine("Exit reached!");
             }
+        }
 
-            // Keep player and enemy on screen so they dony despawn (super mega temporary)
-            // player left
-            if (player->position.x < 0) {player->position.x = 0; player->velocity.x *= -0.5f;}
-            // player right
-            if (player->position.x > GetScreenWidth() - player->size.x) {player->position.x = GetScreenWidth() - player->size.x; player->velocity.x *= -0.5f;}
-            // player top
-            if (player->position.y < 0) {player->position.y = 0; player->velocity.y *= -0.5f;}
-            // player bottom
-            if (player->position.y > GetScreenHeight() - player->size.y) {player->position.y = GetScreenHeight() - player->size.y; player->velocity.y *= -0.5f;}
-            // enemy left
-            if (enemy->position.x < 0) {enemy->position.x = 0; enemy->velocity.x *= -0.5f;}
-            // enemy right
-            if (enemy->position.x > GetScreenWidth() - enemy->size.x) {enemy->position.x = GetScreenWidth() - enemy->size.x; enemy->velocity.x *= -0.5f;}
-            // enemy top
-            if (enemy->position.y < 0) {enemy->position.y = 0; enemy->velocity.y *= -0.5f;}
-            // enemy bottom
-            if (enemy->position.y > GetScreenHeight() - enemy->size.y) {enemy->position.y = GetScreenHeight() - enemy->size.y; enemy->velocity.y *= -0.5f;}
+        // Walls stop projectiles too
+        for (const TileCollision& collision : game.GetTileCollisions()) 
+        {
+            if (collision.entity != playerId && collision.entity != enemyId)
+                game.RemoveEntity(collision.entity);
         }
+    });
 
-        Input::Update(); // update all actions
+    game.RegisterSystem("Movement", COMPONENT_ENTITIES | COMPONENT_SIZE | RESOURCE_PLAYER_FORCE | RESOURCE_ENEMY_FORCE, COMPONENT_POSITION | COMPONENT_VELOCITY | COMPONENT_SLEEP, [&](float)
+    {
+        Entity player = game.GetEntity(playerId);
+        Entity enemy = game.GetEntity(enemyId);
+        const Vector2 screen = game.GetViewportSize();
 
-        BeginDrawing();
-        ClearBackground(BLACK);
+        player.AddForce(playerForce);
+        enemy.AddForce(enemyForce);
 
-        game.Draw();
+        // Keep player and enemy on screen so they dony despawn (super mega temporary)
+        // player left
+        if (player.Position().x < 0) {player.Position().x = 0; player.Velocity().x *= -0.5f;}
+        // player right
+        if (player.Position().x > screen.x - player.Size().x) {player.Position().x = screen.x - player.Size().x; player.Velocity().x *= -0.5f;}
+        // player top
+        if (player.Position().y < 0) {player.Position().y = 0; player.Velocity().y *= -0.5f;}
+        // player bottom
+        if (player.Position().y > screen.y - player.Size().y) {player.Position().y = screen.y - player.Size().y; player.Velocity().y *= -0.5f;}
+        // enemy left
+        if (enemy.Position().x < 0) {enemy.Position().x = 0; enemy.Velocity().x *= -0.5f;}
+        // enemy right
+        if (enemy.Position().x > screen.x - enemy.Size().x) {enemy.Position().x = screen.x - enemy.Size().x; enemy.Velocity().x *= -0.5f;}
+        // enemy top
+        if (enemy.Position().y < 0) {enemy.Position().y = 0; enemy.Velocity().y *= -0.5f;}
+        // enemy bottom
+        if (enemy.Position().y > screen.y - enemy.Size().y) {enemy.Position().y = screen.y - enemy.Size().y; enemy.Velocity().y *= -0.5f;}
+
+        // Keep the view under the enemy, its overlaps are checked next tick
+        game.GetEntity(enemyViewId).Position() = {enemy.Position().x, enemy.Position().y + enemy.Size().y, 0};
+    });
+
+    // Simulation runs at a fixed tick rate, drawing interpolates between ticks
+    FixedTimestep timestep(settings.simulation.tickRate, settings.simulation.maxTicksPerFrame);
+    const float dt = timestep.GetTickDelta();
+
+    game.PrintSystemSchedule();
+    Console::PrintLine("Game Started!");
+
+    // Everything drawn in a frame, the same with or without a window
+    Renderer& renderer = game.GetRenderer();
+    auto drawFrame = [&](float alpha)
+    {
+        renderer.BeginFrame(BLACK);
+
+        game.Draw(alpha);
+
+        // Physics stats of the last tick
+        const PhysicsStats& stats = game.GetPhysicsStats();
+        renderer.DrawText(TextFormat("substeps %u (%u bodies)  contacts %u  islands %u", stats.substeps, stats.substeppedBodies, (unsigned)stats.contacts, (unsigned)stats.islands), 10, 10, 10, GRAY);
         // Draw pause menu
         if (isPaused) 
         {
-            int screenW = GetScreenWidth();
-            int screenH = GetScreenHeight();
+            int screenW = (int)renderer.GetViewportSize().x;
+            int screenH = (int)renderer.GetViewportSize().y;
 
             // Pause overlay size
             int overlayW = screenW / 4;
@@ -164,24 +307,75 @@ int main()
             int overlayX = screenW / 2 - overlayW / 2;
             int overlayY = screenH / 2 - overlayH / 2;
 
-            DrawRectangle(overlayX, overlayY, overlayW, overlayH, Fade(WHITE, 0.25f));
+            renderer.DrawRectangle({(float)overlayX, (float)overlayY, (float)overlayW, (float)overlayH}, Fade(WHITE, 0.25f));
 
             // Text positions
-            int titleX = screenW / 2 - MeasureText("PAUSED", 25) / 2;
+            int titleX = screenW / 2 - renderer.MeasureText("PAUSED", 25) / 2;
             int titleY = screenH / 2 - 50;
-            int subtitleX = screenW / 2 - MeasureText("Press ENTER to resume", 10) / 2;
+            int subtitleX = screenW / 2 - renderer.MeasureText("Press ENTER to resume", 10) / 2;
             int subtitleY = screenH / 2 + 25;
 
-            DrawText("PAUSED", titleX, titleY, 25, WHITE);
-            DrawText("Press ENTER to resume", subtitleX, subtitleY, 10, WHITE);
+            renderer.DrawText("PAUSED", titleX, titleY, 25, WHITE);
+            renderer.DrawText("Press ENTER to resume", subtitleX, subtitleY, 10, WHITE);
         }
-        EndDrawing();
+        renderer.EndFrame();
+    };
+
+    if (headless) 
+    {
+        // No input, no frame clock: one tick and one (discarded) frame per
+        // loop. With a tick count run flat out as a benchmark, otherwise
+        // keep real time like a server
+        using Clock = std::chrono::steady_clock;
+        const Clock::time_point start = Clock::now();
+        const Clock::duration tickDuration = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float>(dt));
+
+        long tick = 0;
+        for (; (maxTicks == 0 || tick < maxTicks) && !stopRequested; ++tick) 
+        {
+            game.Update(dt);
+            drawFrame(1.0f);
+
+            if (maxTicks == 0)
+                std::this_thread::sleep_until(start + tickDuration * (tick + 1));
+        }
+
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+        Console::PrintLine(TextFormat("%ld ticks in %.3f s, %.1f ticks/s", tick, seconds, tick / seconds));
+        if (settings.simulation.deterministic)
+            Console::PrintLine(TextFormat("State hash %016llx", (unsigned long long)game.GetStateHash()));
+    }
+
+    while (!headless && !WindowShouldClose()) 
+    {
+        // Pausing
+        if (Input::GetButtonPressed("Pause")) 
+        {
+            isPaused = !isPaused;
+            if(isPaused)
+                Console::PrintLine("Game Paused.");
+            else
+                Console::PrintLine("Game Resumed.");
+        }
+        int ticks = isPaused ? 0 : timestep.Advance(GetFrameTime());
+        for (int tick = 0; tick < ticks; ++tick) 
+        {
+            game.Update(dt);
+        }
+
+        Input::Update(); // update all actions
+
+        drawFrame(timestep.GetAlpha());
     }
 
     // Cleanup
-    Input::Shutdown();
+    JobSystem::Shutdown();
 
-    CloseWindow();
+    if (!headless)
+    {
+        Input::Shutdown();
+        CloseWindow();
+    }
 
     return 0;
-}
\ No newline at end of file
+}
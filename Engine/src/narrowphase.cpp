@@ -0,0 +1,257 @@
+#include "strictmath.h"
+#include "narrowphase.h"
+#include <algorithm>
+#include "integrator.h"
+#include "physics.h"
+#include "simd.h"
+
+namespace Overlap
+{
+    void TestBatch(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                   uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        switch (Integrator::GetPath())
+        {
+            case Integrator::Path::AVX2: TestAVX2(minX, minY, maxX, maxY, box, others, count, hits); break;
+            case Integrator::Path::SSE2: TestSSE2(minX, minY, maxX, maxY, box, others, count, hits); break;
+            default:                     TestScalar(minX, minY, maxX, maxY, box, others, count, hits); break;
+        }
+    }
+
+    void TestScalar(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                    uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        const float boxMinX = minX[box];
+        const float boxMinY = minY[box];
+        const float boxMaxX = maxX[box];
+        const float boxMaxY = maxY[box];
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            // Same order as CheckCollisionRecs(box, other)
+            const uint32_t other = others[i];
+            hits[i] = boxMinX < maxX[other] && boxMaxX > minX[other] &&
+                      boxMinY < maxY[other] && boxMaxY > minY[other];
+        }
+    }
+
+#ifdef TT_X86
+    void TestSSE2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                  uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        const __m128 boxMinX = _mm_set1_ps(minX[box]);
+        const __m128 boxMinY = _mm_set1_ps(minY[box]);
+        const __m128 boxMaxX = _mm_set1_ps(maxX[box]);
+        const __m128 boxMaxY = _mm_set1_ps(maxY[box]);
+        size_t i = 0;
+
+        for (; i + 4 <= count; i += 4)
+        {
+            // No gather before AVX2, load the four partners one by one
+            const uint32_t* o = others + i;
+            const __m128 otherMinX = _mm_setr_ps(minX[o[0]], minX[o[1]], minX[o[2]], minX[o[3]]);
+            const __m128 otherMinY = _mm_setr_ps(minY[o[0]], minY[o[1]], minY[o[2]], minY[o[3]]);
+            const __m128 otherMaxX = _mm_setr_ps(maxX[o[0]], maxX[o[1]], maxX[o[2]], maxX[o[3]]);
+            const __m128 otherMaxY = _mm_setr_ps(maxY[o[0]], maxY[o[1]], maxY[o[2]], maxY[o[3]]);
+
+            const __m128 x = _mm_and_ps(_mm_cmplt_ps(boxMinX, otherMaxX), _mm_cmpgt_ps(boxMaxX, otherMinX));
+            const __m128 y = _mm_and_ps(_mm_cmplt_ps(boxMinY, otherMaxY), _mm_cmpgt_ps(boxMaxY, otherMinY));
+            const int mask = _mm_movemask_ps(_mm_and_ps(x, y));
+
+            hits[i + 0] = (mask >> 0) & 1;
+            hits[i + 1] = (mask >> 1) & 1;
+            hits[i + 2] = (mask >> 2) & 1;
+            hits[i + 3] = (mask >> 3) & 1;
+        }
+
+        TestScalar(minX, minY, maxX, maxY, box, others + i, count - i, hits + i);
+    }
+
+    TT_TARGET_AVX2 void TestAVX2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                                 uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        const __m256 boxMinX = _mm256_set1_ps(minX[box]);
+        const __m256 boxMinY = _mm256_set1_ps(minY[box]);
+        const __m256 boxMaxX = _mm256_set1_ps(maxX[box]);
+        const __m256 boxMaxY = _mm256_set1_ps(maxY[box]);
+        size_t i = 0;
+
+        for (; i + 8 <= count; i += 8)
+        {
+            // Hardware gathers are no faster than separate loads on many
+            // CPUs, so build the lanes from scalar loads like the SSE2 path
+            const uint32_t* o = others + i;
+            const __m256 otherMinX = _mm256_setr_ps(minX[o[0]], minX[o[1]], minX[o[2]], minX[o[3]], minX[o[4]], minX[o[5]], minX[o[6]], minX[o[7]]);
+            const __m256 otherMinY = _mm256_setr_ps(minY[o[0]], minY[o[1]], minY[o[2]], minY[o[3]], minY[o[4]], minY[o[5]], minY[o[6]], minY[o[7]]);
+            const __m256 otherMaxX = _mm256_setr_ps(maxX[o[0]], maxX[o[1]], maxX[o[2]], maxX[o[3]], maxX[o[4]], maxX[o[5]], maxX[o[6]], maxX[o[7]]);
+            const __m256 otherMaxY = _mm256_setr_ps(maxY[o[0]], maxY[o[1]], maxY[o[2]], maxY[o[3]], maxY[o[4]], maxY[o[5]], maxY[o[6]], maxY[o[7]]);
+
+            // Ordered compares, false on NaN like the scalar ones
+            const __m256 x = _mm256_and_ps(_mm256_cmp_ps(boxMinX, otherMaxX, _CMP_LT_OQ), _mm256_cmp_ps(boxMaxX, otherMinX, _CMP_GT_OQ));
+            const __m256 y = _mm256_and_ps(_mm256_cmp_ps(boxMinY, otherMaxY, _CMP_LT_OQ), _mm256_cmp_ps(boxMaxY, otherMinY, _CMP_GT_OQ));
+            const int mask = _mm256_movemask_ps(_mm256_and_ps(x, y));
+
+            for (int lane = 0; lane < 8; ++lane)
+                hits[i + lane] = (mask >> lane) & 1;
+        }
+
+        // The tail runs non-VEX code, clear the upper halves first to avoid
+        // the AVX/SSE transition penalty
+        _mm256_zeroupper();
+        TestSSE2(minX, minY, maxX, maxY, box, others + i, count - i, hits + i);
+    }
+#else
+    void TestSSE2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                  uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        TestScalar(minX, minY, maxX, maxY, box, others, count, hits);
+    }
+
+    void TestAVX2(const float* minX, const float* minY, const float* maxX, const float* maxY,
+                  uint32_t box, const uint32_t* others, size_t count, uint8_t* hits)
+    {
+        TestScalar(minX, minY, maxX, maxY, box, others, count, hits);
+    }
+#endif
+}
+
+// Keep the earlier of the bullet's current hit and this one. Ties go to the
+// lower row so the result doesn't depend on candidate order
+static void SweepBullet(const EntityStore& store, uint32_t bullet, uint32_t other, std::vector<Impact>& earliest)
+{
+    const Vector3& start = store.previousPositions[bullet];
+    const Vector3& end = store.positions[bullet];
+    const Vector3& size = store.sizes[bullet];
+    const Vector3& otherStart = store.previousPositions[other];
+    const Vector3& otherEnd = store.positions[other];
+    const Vector3& otherSize = store.sizes[other];
+
+    const Rectangle box = { start.x, start.y, size.x, size.y };
+    const Rectangle otherBox = { otherStart.x, otherStart.y, otherSize.x, otherSize.y };
+
+    float time;
+    if (Physics::SweepTest(box, { end.x - start.x, end.y - start.y }, otherBox, { otherEnd.x - otherStart.x, otherEnd.y - otherStart.y }, time) &&
+        (time < earliest[bullet].time || (time == earliest[bullet].time && other < earliest[bullet].other)))
+    {
+        earliest[bullet] = { bullet, other, time };
+    }
+}
+
+void Narrowphase::SetDeterministic(bool enabled)
+{
+    deterministic = enabled;
+}
+
+void Narrowphase::Update(const EntityStore& store, const std::vector<CollisionPair>& candidates)
+{
+    overlaps.clear();
+    triggerOverlaps.clear();
+    impacts.clear();
+
+    const size_t rows = store.Count();
+    minX.resize(rows);
+    minY.resize(rows);
+    maxX.resize(rows);
+    maxY.resize(rows);
+    for (size_t i = 0; i < rows; ++i)
+    {
+        const Vector3& position = store.positions[i];
+        const Vector3& size = store.sizes[i];
+        minX[i] = position.x;
+        minY[i] = position.y;
+        maxX[i] = position.x + size.x;
+        maxY[i] = position.y + size.y;
+    }
+
+    // Counting sort of the candidates by a
+    offsets.assign(rows + 1, 0);
+    for (const CollisionPair& pair : candidates)
+        ++offsets[pair.a + 1];
+    for (size_t i = 0; i < rows; ++i)
+        offsets[i + 1] += offsets[i];
+
+    partners.resize(candidates.size());
+    for (const CollisionPair& pair : candidates)
+        partners[offsets[pair.a]++] = pair.b;
+    // Filling advanced each offset to the next row's start, shift them back
+    for (size_t i = rows; i > 0; --i)
+        offsets[i] = offsets[i - 1];
+    offsets[0] = 0;
+
+    // Broadphase order can come from hash set iteration, which differs
+    // between standard libraries
+    if (deterministic)
+    {
+        for (size_t row = 0; row < rows; ++row)
+            std::sort(partners.begin() + offsets[row], partners.begin() + offsets[row + 1]);
+    }
+
+    hits.resize(candidates.size());
+    earliest.assign(rows, { 0, 0, 2.0f });
+    bool anyBullet = false;
+    for (size_t row = 0; row < rows; ++row)
+    {
+        const uint32_t begin = offsets[row];
+        const uint32_t end = offsets[row + 1];
+        if (begin == end)
+            continue;
+
+        Overlap::TestBatch(minX.data(), minY.data(), maxX.data(), maxY.data(),
+                           (uint32_t)row, partners.data() + begin, end - begin, hits.data() + begin);
+
+        const bool rowIsBullet = (store.flags[row] & ENTITY_BULLET) != 0;
+        const bool rowIsActive = store.IsRowActive(row);
+        const bool rowIsTrigger = (store.flags[row] & ENTITY_TRIGGER) != 0;
+        for (uint32_t i = begin; i < end; ++i)
+        {
+            const uint32_t partner = partners[i];
+
+            // Triggers are checked even against sleeping bodies, or resting
+            // inside one would look like leaving it
+            const bool partnerIsTrigger = (store.flags[partner] & ENTITY_TRIGGER) != 0;
+            if (rowIsTrigger || partnerIsTrigger)
+            {
+                if (hits[i] && rowIsTrigger != partnerIsTrigger)
+                    triggerOverlaps.push_back(rowIsTrigger ? CollisionPair{(uint32_t)row, partner} : CollisionPair{partner, (uint32_t)row});
+                continue;
+            }
+
+            // Nothing to do between bodies that are both asleep or static
+            if (!rowIsActive && !store.IsRowActive(partner))
+                continue;
+
+            const bool partnerIsBullet = (store.flags[partner] & ENTITY_BULLET) != 0;
+            if (!rowIsBullet && !partnerIsBullet)
+            {
+                if (hits[i])
+                    overlaps.push_back({(uint32_t)row, partner});
+                continue;
+            }
+
+            // Ending up apart doesn't mean they never met, sweep every
+            // candidate (the broadphase bounds cover the bullet's path)
+            anyBullet = true;
+            if (rowIsBullet)
+                SweepBullet(store, (uint32_t)row, partner, earliest);
+            if (partnerIsBullet)
+                SweepBullet(store, partner, (uint32_t)row, earliest);
+        }
+    }
+
+    if (!anyBullet)
+        return;
+
+    for (size_t row = 0; row < rows; ++row)
+    {
+        const Impact& impact = earliest[row];
+        if (impact.time > 1.0f)
+            continue;
+
+        // Bullets that hit each other first, report the pair from the lower row
+        const Impact& back = earliest[impact.other];
+        if (back.time <= 1.0f && back.other == row && impact.other < row)
+            continue;
+
+        impacts.push_back(impact);
+    }
+}
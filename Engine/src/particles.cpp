@@ -0,0 +1,164 @@
+#include "particles.h"
+#include "jobsystem.h"
+
+// Smallest batch of particles worth handing to another thread
+static const size_t PARTICLE_CHUNK = 16384;
+
+ParticleSystem::ParticleSystem(uint32_t capacity) : capacity(capacity > 0 ? capacity : 1)
+{
+    x.resize(this->capacity);
+    y.resize(this->capacity);
+    velocityX.resize(this->capacity);
+    velocityY.resize(this->capacity);
+    life.resize(this->capacity, 0.0f);
+    size.resize(this->capacity);
+    color.resize(this->capacity);
+    drawRects.resize(this->capacity);
+    drawColors.resize(this->capacity);
+}
+
+int ParticleSystem::AddEmitter(const EmitterDesc& desc)
+{
+    emitters.push_back(desc);
+    emitDebt.push_back(0.0f);
+    return (int)emitters.size() - 1;
+}
+
+EmitterDesc& ParticleSystem::GetEmitter(int emitter)
+{
+    return emitters[emitter];
+}
+
+void ParticleSystem::Burst(int emitter, uint32_t count)
+{
+    Emit(emitters[emitter], emitters[emitter].area, count);
+}
+
+void ParticleSystem::Burst(int emitter, uint32_t count, Rectangle area)
+{
+    Emit(emitters[emitter], area, count);
+}
+
+float ParticleSystem::RandomRange(float min, float max)
+{
+    // xorshift32, cheaper than GetRandomValue for this many particles
+    randomState ^= randomState << 13;
+    randomState ^= randomState >> 17;
+    randomState ^= randomState << 5;
+    return min + (max - min) * ((randomState >> 8) * (1.0f / 16777216.0f));
+}
+
+void ParticleSystem::Emit(const EmitterDesc& desc, Rectangle area, uint32_t amount)
+{
+    for (uint32_t n = 0; n < amount; ++n)
+    {
+        // Full: recycle the oldest particle
+        if (count == capacity)
+        {
+            tail = (tail + 1) % capacity;
+            --count;
+        }
+
+        const uint32_t i = (tail + count) % capacity;
+        ++count;
+
+        x[i] = RandomRange(area.x, area.x + area.width);
+        y[i] = RandomRange(area.y, area.y + area.height);
+        velocityX[i] = RandomRange(desc.minVelocity.x, desc.maxVelocity.x);
+        velocityY[i] = RandomRange(desc.minVelocity.y, desc.maxVelocity.y);
+        life[i] = RandomRange(desc.minLifetime, desc.maxLifetime);
+        size[i] = desc.size;
+        color[i] = desc.color;
+    }
+}
+
+void ParticleSystem::UpdateRange(uint32_t begin, uint32_t end, float dt)
+{
+    for (uint32_t i = begin; i < end; ++i)
+    {
+        x[i] += velocityX[i] * dt;
+        y[i] += velocityY[i] * dt;
+        life[i] -= dt;
+    }
+}
+
+void ParticleSystem::Update(float dt)
+{
+    lastDt = dt;
+
+    // The live window may wrap around the end of the ring, update it as
+    // up to two contiguous runs
+    const uint32_t first = tail;
+    const uint32_t firstEnd = tail + count < capacity ? tail + count : capacity;
+    const uint32_t wrapped = tail + count - firstEnd;
+
+    JobSystem::ParallelFor(firstEnd - first, PARTICLE_CHUNK, [this, first, dt](size_t begin, size_t end)
+    {
+        UpdateRange(first + (uint32_t)begin, first + (uint32_t)end, dt);
+    });
+    JobSystem::ParallelFor(wrapped, PARTICLE_CHUNK, [this, dt](size_t begin, size_t end)
+    {
+        UpdateRange((uint32_t)begin, (uint32_t)end, dt);
+    });
+
+    // Lifetimes are roughly in spawn order, so expired particles pile up at
+    // the tail. Ones that die out of order are skipped until the tail passes
+    while (count > 0 && life[tail] <= 0.0f)
+    {
+        tail = (tail + 1) % capacity;
+        --count;
+    }
+
+    // Emit after moving so new particles start exactly at their spawn point
+    for (size_t e = 0; e < emitters.size(); ++e)
+    {
+        emitDebt[e] += emitters[e].rate * dt;
+        const uint32_t amount = (uint32_t)emitDebt[e];
+        emitDebt[e] -= (float)amount;
+        Emit(emitters[e], emitters[e].area, amount);
+    }
+}
+
+void ParticleSystem::Draw(Renderer& renderer, float alpha) const
+{
+    if (count == 0)
+        return;
+
+    // Motion is linear, so the previous tick's position is just one step back
+    const float rewind = (1.0f - alpha) * lastDt;
+
+    size_t visible = 0;
+    for (uint32_t n = 0; n < count; ++n)
+    {
+        const uint32_t i = (tail + n) % capacity;
+        if (life[i] <= 0.0f)
+            continue;
+
+        const float left = x[i] - velocityX[i] * rewind;
+        const float top = y[i] - velocityY[i] * rewind;
+        drawRects[visible] = {left, top, size[i], size[i]};
+        drawColors[visible] = color[i];
+        ++visible;
+    }
+
+    if (visible > 0)
+        renderer.DrawRectangles(drawRects.data(), drawColors.data(), visible);
+}
+
+void ParticleSystem::Clear()
+{
+    tail = 0;
+    count = 0;
+    for (float& debt : emitDebt)
+        debt = 0.0f;
+}
+
+uint32_t ParticleSystem::GetCapacity() const
+{
+    return capacity;
+}
+
+uint32_t ParticleSystem::GetCount() const
+{
+    return count;
+}
@@ -1,3 +1,4 @@
+#include "strictmath.h"
 #include "physics.h"
 #include "raymath.h"
 
@@ -6,8 +7,8 @@ namespace Physics
     // Collision between two entities
     bool CheckCollision(const Entity& a, const Entity& b)
     {
-        Rectangle recA = { a.position.x, a.position.y, a.size.x, a.size.y };
-        Rectangle recB = { b.position.x, b.position.y, b.size.x, b.size.y };
+        Rectangle recA = { a.Position().x, a.Position().y, a.Size().x, a.Size().y };
+        Rectangle recB = { b.Position().x, b.Position().y, b.Size().x, b.Size().y };
 
         return CheckCollisionRecs(recA, recB);
     }
@@ -21,34 +22,73 @@ namespace Physics
     // helper for entity and rectangle
     bool CheckCollision(const Entity& entity, const Rectangle& rect)
     {
-        Rectangle entityRect = { entity.position.x, entity.position.y, entity.size.x, entity.size.y };
+        Rectangle entityRect = { entity.Position().x, entity.Position().y, entity.Size().x, entity.Size().y };
         return CheckCollisionRecs(entityRect, rect);
     }
 
+    bool SweepTest(const Rectangle& a, Vector2 moveA, const Rectangle& b, Vector2 moveB, float& time)
+    {
+        // Work in b's frame: a's corner moves by the relative motion through
+        // b grown by a's size, find when it is inside on both axes
+        const float move[2] = { moveA.x - moveB.x, moveA.y - moveB.y };
+        const float start[2] = { a.x, a.y };
+        const float low[2] = { b.x - a.width, b.y - a.height };
+        const float high[2] = { b.x + b.width, b.y + b.height };
+
+        float enter = 0.0f;
+        float exit = 1.0f;
+        for (int axis = 0; axis < 2; ++axis)
+        {
+            if (move[axis] == 0.0f)
+            {
+                // Not moving on this axis, must already overlap on it
+                if (start[axis] <= low[axis] || start[axis] >= high[axis]) return false;
+                continue;
+            }
+
+            float t1 = (low[axis] - start[axis]) / move[axis];
+            float t2 = (high[axis] - start[axis]) / move[axis];
+            if (t1 > t2) { float swap = t1; t1 = t2; t2 = swap; }
+
+            if (t1 > enter) enter = t1;
+            if (t2 < exit) exit = t2;
+            // Strict, boxes that only touch don't collide
+            if (enter >= exit) return false;
+        }
+
+        time = enter;
+        return true;
+    }
+
     void ResolveCollision(Entity& a, Entity& b)
     {
         // Simple elastic collision resolution. Temporary as fuck
-        Vector3 normal = { b.position.x - a.position.x, b.position.y - a.position.y, 0.0f };
-        float length = sqrt(normal.x * normal.x + normal.y * normal.y);
+        Vector3 normal = { b.Position().x - a.Position().x, b.Position().y - a.Position().y, 0.0f };
+        float length = sqrtf(normal.x * normal.x + normal.y * normal.y);
         if (length == 0) return; // Prevent division by zero
         normal.x /= length;
         normal.y /= length;
 
-        float relativeVelocityX = b.velocity.x - a.velocity.x;
-        float relativeVelocityY = b.velocity.y - a.velocity.y;
+        float relativeVelocityX = b.Velocity().x - a.Velocity().x;
+        float relativeVelocityY = b.Velocity().y - a.Velocity().y;
         float velocityAlongNormal = relativeVelocityX * normal.x + relativeVelocityY * normal.y;
 
         if (velocityAlongNormal > 0) return; // They are moving apart
 
-        float restitution = 0.5f; // Coefficient of restitution (elasticity)
+        // Bounciest of the two, mass 0 doesn't move
+        float restitution = fmaxf(a.Restitution(), b.Restitution());
+        float inverseMassA = a.Mass() > 0 ? 1 / a.Mass() : 0;
+        float inverseMassB = b.Mass() > 0 ? 1 / b.Mass() : 0;
+        if (inverseMassA + inverseMassB == 0) return;
+
         float impulseScalar = -(1 + restitution) * velocityAlongNormal;
-        impulseScalar /= (1 / a.friction) + (1 / b.friction);
+        impulseScalar /= inverseMassA + inverseMassB;
 
         Vector3 impulse = { impulseScalar * normal.x, impulseScalar * normal.y, 0.0f };
 
-        a.velocity.x -= impulse.x / a.friction;
-        a.velocity.y -= impulse.y / a.friction;
-        b.velocity.x += impulse.x / b.friction;
-        b.velocity.y += impulse.y / b.friction;
+        a.Velocity().x -= impulse.x * inverseMassA;
+        a.Velocity().y -= impulse.y * inverseMassA;
+        b.Velocity().x += impulse.x * inverseMassB;
+        b.Velocity().y += impulse.y * inverseMassB;
     }
 }
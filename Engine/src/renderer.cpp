@@ -0,0 +1,167 @@
+#include "renderer.h"
+#include <cmath>
+#include <cstring>
+#include "rlgl.h"
+
+void RaylibRenderer::BeginFrame(Color background)
+{
+    BeginDrawing();
+    ClearBackground(background);
+}
+
+void RaylibRenderer::EndFrame()
+{
+    EndDrawing();
+}
+
+void RaylibRenderer::DrawRectangle(const Rectangle& rect, Color color)
+{
+    DrawRectangles(&rect, &color, 1);
+}
+
+void RaylibRenderer::DrawRectangles(const Rectangle* rects, const Color* colors, size_t count)
+{
+    // Straight into the batch like raylib's DrawRectangleRec: textured with
+    // the shapes texture, otherwise quads after text in the same batch would
+    // sample the font atlas. rlgl flushes on its own when the batch fills
+    // up, between quads
+    const Texture2D texture = GetShapesTexture();
+    const Rectangle source = GetShapesTextureRectangle();
+    const float left = source.x / texture.width;
+    const float top = source.y / texture.height;
+    const float right = (source.x + source.width) / texture.width;
+    const float bottom = (source.y + source.height) / texture.height;
+
+    rlSetTexture(texture.id);
+    rlBegin(RL_QUADS);
+    rlNormal3f(0.0f, 0.0f, 1.0f);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Rectangle& rect = rects[i];
+        rlColor4ub(colors[i].r, colors[i].g, colors[i].b, colors[i].a);
+        rlTexCoord2f(left, top);
+        rlVertex2f(rect.x, rect.y);
+        rlTexCoord2f(left, bottom);
+        rlVertex2f(rect.x, rect.y + rect.height);
+        rlTexCoord2f(right, bottom);
+        rlVertex2f(rect.x + rect.width, rect.y + rect.height);
+        rlTexCoord2f(right, top);
+        rlVertex2f(rect.x + rect.width, rect.y);
+    }
+    rlEnd();
+    rlSetTexture(0);
+}
+
+void RaylibRenderer::DrawText(const char* text, int x, int y, int fontSize, Color color)
+{
+    ::DrawText(text, x, y, fontSize, color);
+}
+
+int RaylibRenderer::MeasureText(const char* text, int fontSize) const
+{
+    return ::MeasureText(text, fontSize);
+}
+
+Vector2 RaylibRenderer::GetViewportSize() const
+{
+    return { (float)GetScreenWidth(), (float)GetScreenHeight() };
+}
+
+NullRenderer::NullRenderer(Vector2 viewportSize)
+    : viewport(viewportSize)
+{
+}
+
+void NullRenderer::BeginFrame(Color)
+{
+    draws = 0;
+}
+
+void NullRenderer::EndFrame()
+{
+    lastDraws = draws;
+    ++frames;
+}
+
+void NullRenderer::DrawRectangle(const Rectangle&, Color)
+{
+    ++draws;
+}
+
+void NullRenderer::DrawRectangles(const Rectangle*, const Color*, size_t)
+{
+    ++draws;
+}
+
+void NullRenderer::DrawText(const char*, int, int, int, Color)
+{
+    ++draws;
+}
+
+int NullRenderer::MeasureText(const char* text, int fontSize) const
+{
+    return (int)strlen(text) * fontSize / 2;
+}
+
+Vector2 NullRenderer::GetViewportSize() const
+{
+    return viewport;
+}
+
+void NullRenderer::SetViewportSize(Vector2 size)
+{
+    viewport = size;
+}
+
+RecordingRenderer::RecordingRenderer(Vector2 viewportSize)
+    : NullRenderer(viewportSize)
+{
+}
+
+void RecordingRenderer::BeginFrame(Color background)
+{
+    NullRenderer::BeginFrame(background);
+    frame.clear();
+}
+
+void RecordingRenderer::EndFrame()
+{
+    NullRenderer::EndFrame();
+    lastFrame.swap(frame);
+}
+
+void RecordingRenderer::DrawRectangle(const Rectangle& rect, Color color)
+{
+    NullRenderer::DrawRectangle(rect, color);
+    frame.push_back({ RenderCommand::RECTANGLE, rect, color, std::string(), {}, {} });
+}
+
+void RecordingRenderer::DrawRectangles(const Rectangle* rects, const Color* colors, size_t count)
+{
+    NullRenderer::DrawRectangles(rects, colors, count);
+    if (count == 0)
+        return;
+
+    RenderCommand command = { RenderCommand::RECTANGLES, rects[0], colors[0], std::string(), {}, {} };
+    float right = rects[0].x + rects[0].width;
+    float bottom = rects[0].y + rects[0].height;
+    for (size_t i = 1; i < count; ++i)
+    {
+        command.rect.x = fminf(command.rect.x, rects[i].x);
+        command.rect.y = fminf(command.rect.y, rects[i].y);
+        right = fmaxf(right, rects[i].x + rects[i].width);
+        bottom = fmaxf(bottom, rects[i].y + rects[i].height);
+    }
+    command.rect.width = right - command.rect.x;
+    command.rect.height = bottom - command.rect.y;
+    command.rects.assign(rects, rects + count);
+    command.colors.assign(colors, colors + count);
+    frame.push_back(std::move(command));
+}
+
+void RecordingRenderer::DrawText(const char* text, int x, int y, int fontSize, Color color)
+{
+    NullRenderer::DrawText(text, x, y, fontSize, color);
+    const Rectangle bounds = { (float)x, (float)y, (float)MeasureText(text, fontSize), (float)fontSize };
+    frame.push_back({ RenderCommand::TEXT, bounds, color, text, {}, {} });
+}
@@ -41,6 +41,8 @@ void Settings::Load()
             file >> video.windowHeight;
         else if (token == "fullscreen")
             file >> video.fullscreen;
+        else if (token == "headless")
+            file >> video.headless;
 
         // -------------------
         // AUDIO
@@ -52,6 +54,28 @@ void Settings::Load()
         else if (token == "sfxVolume")
             file >> audio.sfxVolume;
 
+        // -------------------
+        // SIMULATION
+        // -------------------
+        else if (token == "tickRate")
+            file >> simulation.tickRate;
+        else if (token == "maxTicksPerFrame")
+            file >> simulation.maxTicksPerFrame;
+        else if (token == "workerThreads")
+            file >> simulation.workerThreads;
+        else if (token == "maxParticles")
+            file >> simulation.maxParticles;
+        else if (token == "deterministic")
+            file >> simulation.deterministic;
+        else if (token == "solverIterations")
+            file >> simulation.solverIterations;
+        else if (token == "sleepTime")
+            file >> simulation.sleepTime;
+        else if (token == "maxSubsteps")
+            file >> simulation.maxSubsteps;
+        else if (token == "broadphase")
+            file >> simulation.broadphase;
+
         // -------------------
         // INPUT BINDINGS
         // bind <ActionName> <KeyCode>
@@ -86,6 +110,7 @@ void Settings::Save() const
     file << "windowWidth " << video.windowWidth << "\n";
     file << "windowHeight " << video.windowHeight << "\n";
     file << "fullscreen " << video.fullscreen << "\n";
+    file << "headless " << video.headless << "\n";
 
     // -------------------
     // AUDIO
@@ -94,6 +119,19 @@ void Settings::Save() const
     file << "musicVolume " << audio.musicVolume << "\n";
     file << "sfxVolume " << audio.sfxVolume << "\n";
 
+    // -------------------
+    // SIMULATION
+    // -------------------
+    file << "tickRate " << simulation.tickRate << "\n";
+    file << "maxTicksPerFrame " << simulation.maxTicksPerFrame << "\n";
+    file << "workerThreads " << simulation.workerThreads << "\n";
+    file << "maxParticles " << simulation.maxParticles << "\n";
+    file << "deterministic " << simulation.deterministic << "\n";
+    file << "solverIterations " << simulation.solverIterations << "\n";
+    file << "sleepTime " << simulation.sleepTime << "\n";
+    file << "maxSubsteps " << simulation.maxSubsteps << "\n";
+    file << "broadphase " << simulation.broadphase << "\n";
+
     // -------------------
     // CONTROLS
     // -------------------
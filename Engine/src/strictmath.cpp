@@ -0,0 +1,100 @@
+#include "strictmath.h"
+#include <cfloat>
+#include <cmath>
+
+namespace StrictMath
+{
+    // ln(2) split so n * LN2_HIGH is exact for the n used below
+    static const double LN2 = 0.69314718055994530942;
+    static const double LN2_HIGH = 0.693147180369123816490;
+    static const double LN2_LOW = 1.90821492927058770002e-10;
+    static const double SQRT_HALF = 0.70710678118654752440;
+    // pi / 2 split the same way for the sin range reduction
+    static const double PI_HALF = 1.57079632679489661923;
+    static const double PI_HALF_HIGH = 1.57079632673412561417;
+    static const double PI_HALF_LOW = 6.07710050650619224932e-11;
+
+    // frexp, ldexp and floor are exact, so they are safe to take from the library
+
+    static double Log(double x)
+    {
+        // x = m * 2^k with m in [sqrt(1/2), sqrt(2))
+        int k;
+        double m = frexp(x, &k);
+        if (m < SQRT_HALF)
+        {
+            m *= 2.0;
+            k -= 1;
+        }
+
+        // ln(m) = 2 * atanh(s), |s| < 0.18 so the series is done by s^19
+        const double s = (m - 1.0) / (m + 1.0);
+        const double s2 = s * s;
+        double series = 1.0 / 19.0;
+        for (int n = 17; n >= 1; n -= 2)
+            series = series * s2 + 1.0 / n;
+
+        return k * LN2 + 2.0 * s * series;
+    }
+
+    static double Exp(double x)
+    {
+        if (x < -745.0)
+            return 0.0;
+        if (x > 709.0)
+            return HUGE_VAL;
+
+        // x = n * ln(2) + r with |r| <= ln(2) / 2
+        const double n = floor(x / LN2 + 0.5);
+        const double r = (x - n * LN2_HIGH) - n * LN2_LOW;
+
+        // Taylor series, the r^14 term is below double precision
+        double series = 1.0;
+        for (int i = 13; i >= 1; --i)
+            series = series * r / i + 1.0;
+
+        return ldexp(series, (int)n);
+    }
+
+    float Pow(float base, float exponent)
+    {
+        if (exponent == 0.0f || base == 1.0f)
+            return 1.0f;
+        if (exponent == 1.0f)
+            return base;
+        if (base <= 0.0f)
+            return exponent > 0.0f ? 0.0f : HUGE_VALF;
+
+        // Worked in double, rounding to float hides the series error
+        return (float)Exp(exponent * Log(base));
+    }
+
+    float Sin(float x)
+    {
+        if (x != x || x - x != 0.0f)
+            return x - x; // NaN for NaN and infinities
+
+        // x = n * pi/2 + r with |r| <= pi/4, n picks the quadrant
+        const double n = floor(x / PI_HALF + 0.5);
+        const double r = (x - n * PI_HALF_HIGH) - n * PI_HALF_LOW;
+        const double r2 = r * r;
+        const int quadrant = (int)(n - 4.0 * floor(n / 4.0));
+
+        // Taylor series for sin(r) or cos(r), the next terms are below
+        // double precision for |r| <= pi/4
+        double series = 1.0;
+        if (quadrant % 2 == 0)
+        {
+            for (int i = 17; i >= 3; i -= 2)
+                series = 1.0 - series * r2 / (i * (i - 1));
+            series *= r;
+        }
+        else
+        {
+            for (int i = 16; i >= 2; i -= 2)
+                series = 1.0 - series * r2 / (i * (i - 1));
+        }
+
+        return (float)(quadrant < 2 ? series : -series);
+    }
+}
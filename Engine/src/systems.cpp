@@ -0,0 +1,99 @@
+#include "systems.h"
+#include "console.h"
+#include "jobsystem.h"
+
+void SystemScheduler::Register(const std::string& name, uint32_t reads, uint32_t writes, SystemFunction function)
+{
+    systems.push_back({name, reads, writes, function});
+    dirty = true;
+}
+
+void SystemScheduler::BuildBatches()
+{
+    // depth[i] = 1 + deepest earlier system that i conflicts with
+    std::vector<size_t> depth(systems.size(), 0);
+    size_t maxDepth = 0;
+
+    for (size_t i = 0; i < systems.size(); ++i)
+    {
+        for (size_t j = 0; j < i; ++j)
+        {
+            const System& a = systems[j];
+            const System& b = systems[i];
+            bool conflict = (a.writes & (b.reads | b.writes)) || (b.writes & a.reads);
+            if (conflict && depth[j] + 1 > depth[i])
+                depth[i] = depth[j] + 1;
+        }
+        if (depth[i] > maxDepth)
+            maxDepth = depth[i];
+    }
+
+    batches.assign(systems.empty() ? 0 : maxDepth + 1, {});
+    for (size_t i = 0; i < systems.size(); ++i)
+        batches[depth[i]].push_back(i);
+
+    dirty = false;
+}
+
+void SystemScheduler::RunSystem(void* data, size_t begin, size_t end)
+{
+    SystemScheduler* scheduler = (SystemScheduler*)data;
+    for (size_t i = begin; i < end; ++i)
+        scheduler->systems[i].function(scheduler->currentDt);
+}
+
+void SystemScheduler::Run(float dt)
+{
+    if (dirty)
+        BuildBatches();
+
+    currentDt = dt;
+
+    for (const std::vector<size_t>& batch : batches)
+    {
+        // Nothing to overlap with, skip the job round trip
+        if (batch.size() == 1 || deterministic)
+        {
+            for (size_t index : batch)
+                systems[index].function(dt);
+            continue;
+        }
+
+        JobCounter counter;
+        for (size_t index : batch)
+        {
+            Job job;
+            job.function = &SystemScheduler::RunSystem;
+            job.data = this;
+            job.begin = index;
+            job.end = index + 1;
+            job.counter = &counter;
+            JobSystem::Run(job);
+        }
+        JobSystem::Wait(counter);
+    }
+}
+
+void SystemScheduler::SetDeterministic(bool enabled)
+{
+    deterministic = enabled;
+}
+
+const std::vector<std::vector<size_t>>& SystemScheduler::GetBatches()
+{
+    if (dirty)
+        BuildBatches();
+    return batches;
+}
+
+void SystemScheduler::PrintSchedule()
+{
+    GetBatches();
+    for (size_t i = 0; i < batches.size(); ++i)
+    {
+        std::string line = "Batch " + std::to_string(i) + ":";
+        for (size_t index : batches[i])
+            line += " " + systems[index].name;
+        Console::PrintLine(line);
+    }
+}
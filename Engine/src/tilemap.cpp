@@ -0,0 +1,537 @@
+#include "strictmath.h"
+#include "tilemap.h"
+#include <cfloat>
+#include <cmath>
+#include <fstream>
+#include "console.h"
+
+// Boxes resting flush against a wall aren't counted as inside it when they
+// slide along it, rounding can leave them a hair over the edge
+static const float SKIN = 0.001f;
+
+void TileMap::Resize(int newWidth, int newHeight)
+{
+    width = newWidth > 0 ? newWidth : 0;
+    height = newHeight > 0 ? newHeight : 0;
+    wordsPerRow = (width + 63) / 64;
+
+    tiles.assign((size_t)width * height, TILE_EMPTY);
+    walls.assign((size_t)wordsPerRow * height, 0);
+    baked = false;
+}
+
+bool TileMap::Load(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file.is_open())
+        return false;
+
+    int fileWidth = 0, fileHeight = 0;
+    if (!(file >> fileWidth >> fileHeight) || fileWidth <= 0 || fileHeight <= 0)
+        return false;
+
+    std::vector<std::string> rows(fileHeight);
+    for (std::string& row : rows)
+    {
+        if (!(file >> row) || (int)row.size() != fileWidth)
+            return false;
+        for (char c : row)
+        {
+            if (c < '0' || c > '0' + TILE_EXIT)
+                return false;
+        }
+    }
+
+    Resize(fileWidth, fileHeight);
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+            SetTile(x, y, (TileType)(rows[y][x] - '0'));
+    }
+
+    Console::PrintLine("Level loaded: " + path);
+    return true;
+}
+
+void TileMap::SetOrigin(Vector2 position)
+{
+    origin = position;
+    baked = false;
+}
+
+void TileMap::SetTileSize(float size)
+{
+    tileSize = size > 0 ? size : 1.0f;
+    baked = false;
+}
+
+void TileMap::SetTile(int x, int y, TileType type)
+{
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return;
+
+    tiles[(size_t)y * width + x] = type;
+
+    uint64_t& word = walls[(size_t)y * wordsPerRow + (x >> 6)];
+    const uint64_t bit = 1ull << (x & 63);
+    const uint64_t before = word;
+    if (type == TILE_WALL)
+        word |= bit;
+    else
+        word &= ~bit;
+    if (word != before)
+        baked = false;
+}
+
+TileType TileMap::GetTile(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return TILE_EMPTY;
+    return (TileType)tiles[(size_t)y * width + x];
+}
+
+bool TileMap::IsSolid(int x, int y) const
+{
+    if (x < 0 || y < 0 || x >= width || y >= height)
+        return false;
+    return (walls[(size_t)y * wordsPerRow + (x >> 6)] >> (x & 63)) & 1;
+}
+
+bool TileMap::FindTile(TileType type, int& x, int& y) const
+{
+    for (size_t i = 0; i < tiles.size(); ++i)
+    {
+        if (tiles[i] == type)
+        {
+            x = (int)(i % width);
+            y = (int)(i / width);
+            return true;
+        }
+    }
+    return false;
+}
+
+Rectangle TileMap::GetTileBounds(int x, int y) const
+{
+    return { origin.x + x * tileSize, origin.y + y * tileSize, tileSize, tileSize };
+}
+
+void TileMap::Bake()
+{
+    if (baked)
+        return;
+    baked = true;
+
+    colliders.clear();
+    tileColliders.assign(tiles.size(), UINT32_MAX);
+    unmerged = walls;
+
+    for (int y = 0; y < height; ++y)
+    {
+        uint64_t* row = &unmerged[(size_t)y * wordsPerRow];
+        for (int x = 0; x < width; ++x)
+        {
+            // Skip whole empty words
+            if (row[x >> 6] == 0)
+            {
+                x |= 63;
+                continue;
+            }
+            if (!((row[x >> 6] >> (x & 63)) & 1))
+                continue;
+
+            // Run of wall tiles to the right
+            int runWidth = 1;
+            while (x + runWidth < width && ((row[(x + runWidth) >> 6] >> ((x + runWidth) & 63)) & 1))
+                ++runWidth;
+
+            // Then down while the whole run is wall and not merged yet
+            int runHeight = 1;
+            while (y + runHeight < height)
+            {
+                const uint64_t* below = &unmerged[(size_t)(y + runHeight) * wordsPerRow];
+                bool full = true;
+                for (int i = x; i < x + runWidth && full; ++i)
+                    full = (below[i >> 6] >> (i & 63)) & 1;
+                if (!full)
+                    break;
+                ++runHeight;
+            }
+
+            const uint32_t collider = (uint32_t)colliders.size();
+            colliders.push_back({ origin.x + x * tileSize, origin.y + y * tileSize, runWidth * tileSize, runHeight * tileSize });
+            for (int j = y; j < y + runHeight; ++j)
+            {
+                uint64_t* merged = &unmerged[(size_t)j * wordsPerRow];
+                for (int i = x; i < x + runWidth; ++i)
+                {
+                    merged[i >> 6] &= ~(1ull << (i & 63));
+                    tileColliders[(size_t)j * width + i] = collider;
+                }
+            }
+            x += runWidth - 1;
+        }
+    }
+}
+
+void TileMap::SetCollisionLayer(uint32_t layer)
+{
+    collisionLayer = layer;
+}
+
+void TileMap::GetSpan(float min, float max, float start, int count, int& first, int& last) const
+{
+    // Clamp as floats, the span can be far outside the grid
+    const float low = floorf((min - start) / tileSize);
+    const float high = ceilf((max - start) / tileSize) - 1;
+    first = low < 0 ? 0 : (low >= count ? count : (int)low);
+    last = high < 0 ? -1 : (high >= count ? count - 1 : (int)high);
+}
+
+bool TileMap::RowHasWall(int y, int firstX, int lastX) const
+{
+    const uint64_t* row = &walls[(size_t)y * wordsPerRow];
+    const int firstWord = firstX >> 6;
+    const int lastWord = lastX >> 6;
+
+    for (int word = firstWord; word <= lastWord; ++word)
+    {
+        uint64_t mask = ~0ull;
+        if (word == firstWord)
+            mask &= ~0ull << (firstX & 63);
+        if (word == lastWord)
+            mask &= ~0ull >> (63 - (lastX & 63));
+        if (row[word] & mask)
+            return true;
+    }
+    return false;
+}
+
+bool TileMap::ColumnHasWall(int x, int firstY, int lastY) const
+{
+    const size_t word = x >> 6;
+    const int bit = x & 63;
+    for (int y = firstY; y <= lastY; ++y)
+    {
+        if ((walls[(size_t)y * wordsPerRow + word] >> bit) & 1)
+            return true;
+    }
+    return false;
+}
+
+bool TileMap::Overlaps(const Rectangle& box) const
+{
+    int firstX, lastX, firstY, lastY;
+    GetSpan(box.x, box.x + box.width, origin.x, width, firstX, lastX);
+    GetSpan(box.y, box.y + box.height, origin.y, height, firstY, lastY);
+    if (firstX > lastX)
+        return false;
+
+    for (int y = firstY; y <= lastY; ++y)
+    {
+        if (RowHasWall(y, firstX, lastX))
+            return true;
+    }
+    return false;
+}
+
+void TileMap::Collide(EntityStore& store)
+{
+    hits.clear();
+    if (width == 0 || height == 0)
+        return;
+    Bake();
+
+    for (size_t i = 0; i < store.Count(); ++i)
+    {
+        if (!store.IsRowActive(i) || (store.flags[i] & (ENTITY_NO_COLLISION | ENTITY_TRIGGER)) || !(store.collisionMasks[i] & collisionLayer))
+            continue;
+
+        const Vector3& previous = store.previousPositions[i];
+        const Vector3& size = store.sizes[i];
+        Vector3& position = store.positions[i];
+        Vector3& velocity = store.velocities[i];
+        const float restitution = store.restitutions[i];
+
+        // Horizontal move, over the rows the box started in
+        float x = position.x;
+        int firstY, lastY;
+        GetSpan(previous.y + SKIN, previous.y + size.y - SKIN, origin.y, height, firstY, lastY);
+        if (position.x != previous.x && firstY <= lastY)
+        {
+            const bool right = position.x > previous.x;
+            int first, last;
+            if (right)
+                GetSpan(previous.x + size.x, position.x + size.x, origin.x, width, first, last);
+            else
+                GetSpan(position.x, previous.x, origin.x, width, first, last);
+
+            // Walk columns in the direction of motion, stop at the first wall
+            const int step = right ? 1 : -1;
+            for (int column = right ? first : last; first <= last && column >= first && column <= last; column += step)
+            {
+                if (!ColumnHasWall(column, firstY, lastY))
+                    continue;
+
+                x = right ? origin.x + column * tileSize - size.x : origin.x + (column + 1) * tileSize;
+                if (right == (velocity.x > 0))
+                    velocity.x = -velocity.x * restitution;
+                int wallY = firstY;
+                while (!IsSolid(column, wallY))
+                    ++wallY;
+                hits.push_back({ (uint32_t)i, column, wallY, tileColliders[(size_t)wallY * width + column], { right ? -1.0f : 1.0f, 0 } });
+                break;
+            }
+        }
+        position.x = x;
+
+        // Vertical move, over the columns the box ends up in
+        float y = position.y;
+        int firstX, lastX;
+        GetSpan(x + SKIN, x + size.x - SKIN, origin.x, width, firstX, lastX);
+        if (position.y != previous.y && firstX <= lastX)
+        {
+            const bool down = position.y > previous.y;
+            int first, last;
+            if (down)
+                GetSpan(previous.y + size.y, position.y + size.y, origin.y, height, first, last);
+            else
+                GetSpan(position.y, previous.y, origin.y, height, first, last);
+
+            const int step = down ? 1 : -1;
+            for (int row = down ? first : last; first <= last && row >= first && row <= last; row += step)
+            {
+                if (!RowHasWall(row, firstX, lastX))
+                    continue;
+
+                y = down ? origin.y + row * tileSize - size.y : origin.y + (row + 1) * tileSize;
+                if (down == (velocity.y > 0))
+                    velocity.y = -velocity.y * restitution;
+                int wallX = firstX;
+                while (!IsSolid(wallX, row))
+                    ++wallX;
+                hits.push_back({ (uint32_t)i, wallX, row, tileColliders[(size_t)row * width + wallX], { 0, down ? -1.0f : 1.0f } });
+                break;
+            }
+        }
+        position.y = y;
+
+        Depenetrate(store, i);
+    }
+}
+
+float TileMap::EscapeDistance(const Rectangle& box, int axis, int sign) const
+{
+    Rectangle moved = box;
+    float& coordinate = axis == 0 ? moved.x : moved.y;
+    const float length = axis == 0 ? box.width : box.height;
+    const float start = axis == 0 ? origin.x : origin.y;
+    const int count = axis == 0 ? width : height;
+
+    // Jump past the furthest wall in the way until the box is clear. Each
+    // jump clears at least one tile, so the grid runs out within count
+    for (int jump = 0; jump <= count; ++jump)
+    {
+        int firstX, lastX, firstY, lastY;
+        GetSpan(moved.x + SKIN, moved.x + moved.width - SKIN, origin.x, width, firstX, lastX);
+        GetSpan(moved.y + SKIN, moved.y + moved.height - SKIN, origin.y, height, firstY, lastY);
+        if (firstX > lastX || firstY > lastY)
+            break;
+
+        int wall = -1;
+        if (axis == 0)
+        {
+            for (int x = sign > 0 ? lastX : firstX; x >= firstX && x <= lastX; x -= sign)
+            {
+                if (ColumnHasWall(x, firstY, lastY))
+                {
+                    wall = x;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            for (int y = sign > 0 ? lastY : firstY; y >= firstY && y <= lastY; y -= sign)
+            {
+                if (RowHasWall(y, firstX, lastX))
+                {
+                    wall = y;
+                    break;
+                }
+            }
+        }
+        if (wall < 0)
+            break;
+
+        coordinate = sign > 0 ? start + (wall + 1) * tileSize : start + wall * tileSize - length;
+    }
+
+    return fabsf(coordinate - (axis == 0 ? box.x : box.y));
+}
+
+bool TileMap::Depenetrate(EntityStore& store, size_t row)
+{
+    Vector3& position = store.positions[row];
+    const Vector3& size = store.sizes[row];
+    const Rectangle box = { position.x, position.y, size.x, size.y };
+
+    // The first wall tile under the box, reported as what it hit
+    int firstX, lastX, firstY, lastY;
+    GetSpan(box.x + SKIN, box.x + box.width - SKIN, origin.x, width, firstX, lastX);
+    GetSpan(box.y + SKIN, box.y + box.height - SKIN, origin.y, height, firstY, lastY);
+    int wallX = -1, wallY = -1;
+    for (int y = firstY; y <= lastY && wallX < 0; ++y)
+    {
+        if (firstX > lastX || !RowHasWall(y, firstX, lastX))
+            continue;
+        wallY = y;
+        wallX = firstX;
+        while (!IsSolid(wallX, y))
+            ++wallX;
+    }
+    if (wallX < 0)
+        return false;
+
+    // Shortest of the four ways out
+    static const int AXES[4] = { 0, 0, 1, 1 };
+    static const int SIGNS[4] = { -1, 1, -1, 1 };
+    int best = 0;
+    float bestDistance = FLT_MAX;
+    for (int way = 0; way < 4; ++way)
+    {
+        const float distance = EscapeDistance(box, AXES[way], SIGNS[way]);
+        if (distance < bestDistance)
+        {
+            bestDistance = distance;
+            best = way;
+        }
+    }
+
+    Vector3& velocity = store.velocities[row];
+    const float sign = (float)SIGNS[best];
+    if (AXES[best] == 0)
+    {
+        position.x += sign * bestDistance;
+        if (velocity.x * sign < 0)
+            velocity.x = 0;
+    }
+    else
+    {
+        position.y += sign * bestDistance;
+        if (velocity.y * sign < 0)
+            velocity.y = 0;
+    }
+
+    const Vector2 normal = AXES[best] == 0 ? Vector2{ sign, 0 } : Vector2{ 0, sign };
+    hits.push_back({ (uint32_t)row, wallX, wallY, tileColliders[(size_t)wallY * width + wallX], normal });
+    return true;
+}
+
+bool TileMap::Raycast(Vector2 rayOrigin, Vector2 direction, float maxDistance, TileRayHit& hit) const
+{
+    const float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+    if (length == 0 || width == 0 || height == 0)
+        return false;
+
+    const float d[2] = { direction.x / length, direction.y / length };
+    const float o[2] = { rayOrigin.x, rayOrigin.y };
+    const float gridMin[2] = { origin.x, origin.y };
+    const float gridMax[2] = { origin.x + width * tileSize, origin.y + height * tileSize };
+    const int count[2] = { width, height };
+
+    // Clip the ray to the grid, remembering which face it came in through
+    float enter = 0;
+    float exit = maxDistance;
+    float normal[2] = { 0, 0 };
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (d[axis] == 0)
+        {
+            if (o[axis] < gridMin[axis] || o[axis] >= gridMax[axis])
+                return false;
+            continue;
+        }
+
+        float entry = (gridMin[axis] - o[axis]) / d[axis];
+        float leave = (gridMax[axis] - o[axis]) / d[axis];
+        if (entry > leave)
+        {
+            const float swap = entry;
+            entry = leave;
+            leave = swap;
+        }
+        if (entry > enter)
+        {
+            enter = entry;
+            normal[0] = normal[1] = 0;
+            normal[axis] = d[axis] > 0 ? -1.0f : 1.0f;
+        }
+        if (leave < exit)
+            exit = leave;
+    }
+    if (enter > exit)
+        return false;
+
+    // Tile the ray starts in, then step one tile boundary at a time
+    int cell[2], step[2];
+    float next[2], delta[2];
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        const float start = (o[axis] + d[axis] * enter - gridMin[axis]) / tileSize;
+        cell[axis] = (int)floorf(start);
+        if (cell[axis] < 0) cell[axis] = 0;
+        if (cell[axis] >= count[axis]) cell[axis] = count[axis] - 1;
+
+        if (d[axis] > 0)
+        {
+            step[axis] = 1;
+            next[axis] = (gridMin[axis] + (cell[axis] + 1) * tileSize - o[axis]) / d[axis];
+            delta[axis] = tileSize / d[axis];
+        }
+        else if (d[axis] < 0)
+        {
+            step[axis] = -1;
+            next[axis] = (gridMin[axis] + cell[axis] * tileSize - o[axis]) / d[axis];
+            delta[axis] = -tileSize / d[axis];
+        }
+        else
+        {
+            step[axis] = 0;
+            next[axis] = FLT_MAX;
+            delta[axis] = FLT_MAX;
+        }
+    }
+
+    float distance = enter;
+    while (distance <= exit)
+    {
+        if (IsSolid(cell[0], cell[1]))
+        {
+            hit.x = cell[0];
+            hit.y = cell[1];
+            hit.distance = distance;
+            hit.point = { o[0] + d[0] * distance, o[1] + d[1] * distance };
+            hit.normal = { normal[0], normal[1] };
+            return true;
+        }
+
+        const int axis = next[0] < next[1] ? 0 : 1;
+        distance = next[axis];
+        next[axis] += delta[axis];
+        cell[axis] += step[axis];
+        normal[0] = normal[1] = 0;
+        normal[axis] = (float)-step[axis];
+
+        if (cell[axis] < 0 || cell[axis] >= count[axis])
+            return false;
+    }
+    return false;
+}
+
+void TileMap::Draw(Renderer& renderer, Color color)
+{
+    Bake();
+    for (const Rectangle& collider : colliders)
+        renderer.DrawRectangle(collider, color);
+}
@@ -0,0 +1,36 @@
+#include "timestep.h"
+#include <cmath>
+
+FixedTimestep::FixedTimestep(int tickRate, int maxTicksPerFrame)
+{
+    tickDelta = 1.0f / (tickRate > 0 ? tickRate : 60);
+    maxTicks = maxTicksPerFrame > 0 ? maxTicksPerFrame : 1;
+}
+
+int FixedTimestep::Advance(float frameTime)
+{
+    accumulator += frameTime;
+
+    int ticks = 0;
+    while (accumulator >= tickDelta && ticks < maxTicks)
+    {
+        accumulator -= tickDelta;
+        ++ticks;
+    }
+
+    // Hit the cap, drop the backlog but keep the partial tick for interpolation
+    if (ticks == maxTicks && accumulator >= tickDelta)
+        accumulator = fmodf(accumulator, tickDelta);
+
+    return ticks;
+}
+
+float FixedTimestep::GetTickDelta() const
+{
+    return tickDelta;
+}
+
+float FixedTimestep::GetAlpha() const
+{
+    return accumulator / tickDelta;
+}
@@ -0,0 +1,61 @@
+#include "triggers.h"
+#include <algorithm>
+
+uint64_t TriggerTracker::Key(EntityId trigger, EntityId other)
+{
+    return (uint64_t)trigger.index << 32 | other.index;
+}
+
+void TriggerTracker::Update(const EntityStore& store, const std::vector<CollisionPair>& overlaps)
+{
+    ++tick;
+    events.clear();
+
+    // Stamp the pairs still inside, remember the new ones
+    entered.clear();
+    for (const CollisionPair& pair : overlaps)
+    {
+        const EntityId trigger = store.ids[pair.a];
+        const EntityId other = store.ids[pair.b];
+
+        auto result = inside.try_emplace(Key(trigger, other));
+        Inside& entry = result.first->second;
+        if (!result.second)
+        {
+            if (entry.trigger == trigger && entry.other == other)
+            {
+                entry.tick = tick;
+                continue;
+            }
+
+            // A reused slot is a different entity, the old one left
+            events.push_back({ entry.trigger, entry.other, TRIGGER_EXIT });
+        }
+        entry = { trigger, other, tick };
+        entered.push_back({ trigger, other, TRIGGER_ENTER });
+    }
+
+    // Exits in key order, map order differs between standard libraries
+    for (auto it = inside.begin(); it != inside.end(); )
+    {
+        if (it->second.tick != tick)
+        {
+            events.push_back({ it->second.trigger, it->second.other, TRIGGER_EXIT });
+            it = inside.erase(it);
+        }
+        else
+            ++it;
+    }
+    std::sort(events.begin(), events.end(), [](const TriggerEvent& a, const TriggerEvent& b)
+    {
+        return Key(a.trigger, a.other) < Key(b.trigger, b.other);
+    });
+
+    events.insert(events.end(), entered.begin(), entered.end());
+}
+
+bool TriggerTracker::IsInside(EntityId trigger, EntityId other) const
+{
+    auto it = inside.find(Key(trigger, other));
+    return it != inside.end() && it->second.trigger == trigger && it->second.other == other;
+}
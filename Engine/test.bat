@@ -0,0 +1,73 @@
+@echo off
+setlocal
+
+:: -------------------------------
+:: CONFIGURATION
+:: -------------------------------
+set "SRC_PATH=src"
+set "TEST_PATH=tests"
+set "BUILD_PATH=build\tests"
+set "LIB_PATH=lib"
+set "INCLUDE_PATH=include"
+:: Precise floating point without FMA contraction, see strictmath.h. GCC and
+:: Clang builds use -ffp-contract=off (and never -ffast-math) instead
+set "FP_FLAGS=/fp:precise"
+
+:: Create build folder if it doesn't exist
+if not exist "%BUILD_PATH%" mkdir "%BUILD_PATH%"
+
+:: -------------------------------
+:: SETUP VISUAL STUDIO ENVIRONMENT
+:: -------------------------------
+call "C:\Program Files (x86)\Microsoft Visual Studio\18\BuildTools\VC\Auxiliary\Build\vcvars64.bat" >nul 2>&1
+if errorlevel 1 (
+    echo [ERROR] Failed to initialize Visual Studio environment.
+    pause
+    exit /b 1
+)
+
+:: -------------------------------
+:: COMPILE ENGINE
+:: -------------------------------
+echo Compiling engine...
+
+:: Engine objects without main, every test links against them
+cl /c /EHsc /MD /std:c++17 %FP_FLAGS% /I"%INCLUDE_PATH%" /Fo"%BUILD_PATH%\\" "%SRC_PATH%\*.cpp" >nul
+if errorlevel 1 (
+    echo.
+    echo [BUILD FAILED] Fix errors above.
+    pause
+    exit /b 1
+)
+del "%BUILD_PATH%\main.obj"
+
+:: -------------------------------
+:: BUILD AND RUN EACH TEST
+:: -------------------------------
+set "FAILED=0"
+for %%T in ("%TEST_PATH%\*.cpp") do (
+    cl /EHsc /MD /std:c++17 %FP_FLAGS% /I"%INCLUDE_PATH%" /Fo"%BUILD_PATH%\%%~nT.obj" /Fe"%BUILD_PATH%\%%~nT.exe" "%%T" "%BUILD_PATH%\*.obj" /link /LIBPATH:"%LIB_PATH%" ^
+        raylib.lib ^
+        opengl32.lib gdi32.lib user32.lib kernel32.lib winmm.lib shell32.lib advapi32.lib >nul
+    if errorlevel 1 (
+        echo [BUILD FAILED] %%~nT
+        set "FAILED=1"
+    ) else (
+        "%BUILD_PATH%\%%~nT.exe"
+        if errorlevel 1 set "FAILED=1"
+    )
+    del "%BUILD_PATH%\%%~nT.obj" >nul 2>&1
+)
+
+:: -------------------------------
+:: CHECK TEST SUCCESS
+:: -------------------------------
+echo.
+if "%FAILED%"=="1" (
+    echo [TESTS FAILED]
+    pause
+    exit /b 1
+)
+
+echo All tests passed.
+pause
@@ -0,0 +1,199 @@
+// AABBTree queries have to give the same answers as testing every box,
+// while boxes move, get removed and get added
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "aabbtree.h"
+#include "check.h"
+
+static float RandomFloat(float min, float max)
+{
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+static Rectangle RandomBox()
+{
+    return {RandomFloat(0, 1000), RandomFloat(0, 1000), RandomFloat(1, 30), RandomFloat(1, 30)};
+}
+
+struct Item
+{
+    Rectangle box;
+    int32_t proxy = AABBTree::NULL_NODE; // NULL_NODE = removed
+};
+
+static bool Overlaps(const Rectangle& a, const Rectangle& b)
+{
+    return a.x < b.x + b.width && b.x < a.x + a.width && a.y < b.y + b.height && b.y < a.y + a.height;
+}
+
+static std::vector<uint32_t> BruteQuery(const std::vector<Item>& items, const Rectangle& query)
+{
+    std::vector<uint32_t> result;
+    for (uint32_t i = 0; i < items.size(); ++i)
+    {
+        if (items[i].proxy != AABBTree::NULL_NODE && Overlaps(items[i].box, query))
+            result.push_back(i);
+    }
+    return result;
+}
+
+// Entry distance of a normalized ray into box, FLT_MAX on a miss or when
+// the origin is inside
+static float RayDistance(const Rectangle& box, Vector2 origin, Vector2 dir, float maxDistance)
+{
+    if (origin.x > box.x && origin.x < box.x + box.width && origin.y > box.y && origin.y < box.y + box.height)
+        return FLT_MAX;
+
+    float tNear = -FLT_MAX;
+    float tFar = FLT_MAX;
+    const float min[2] = {box.x, box.y};
+    const float max[2] = {box.x + box.width, box.y + box.height};
+    const float o[2] = {origin.x, origin.y};
+    const float d[2] = {dir.x, dir.y};
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        if (d[axis] == 0)
+        {
+            if (o[axis] <= min[axis] || o[axis] >= max[axis])
+                return FLT_MAX;
+            continue;
+        }
+        const float t1 = (min[axis] - o[axis]) / d[axis];
+        const float t2 = (max[axis] - o[axis]) / d[axis];
+        tNear = std::max(tNear, std::min(t1, t2));
+        tFar = std::min(tFar, std::max(t1, t2));
+    }
+    if (tNear > tFar || tFar < 0 || tNear > maxDistance)
+        return FLT_MAX;
+    return std::max(tNear, 0.0f);
+}
+
+static float DistanceSquared(const Rectangle& box, Vector2 point)
+{
+    const float dx = std::max(std::max(box.x - point.x, point.x - (box.x + box.width)), 0.0f);
+    const float dy = std::max(std::max(box.y - point.y, point.y - (box.y + box.height)), 0.0f);
+    return dx * dx + dy * dy;
+}
+
+static void CheckQueries(const AABBTree& tree, const std::vector<Item>& items)
+{
+    std::vector<uint32_t> results;
+    for (int i = 0; i < 50; ++i)
+    {
+        const Rectangle query = {RandomFloat(-50, 1000), RandomFloat(-50, 1000), RandomFloat(0, 200), RandomFloat(0, 200)};
+        results.clear();
+        tree.QueryBox(query, results);
+        std::sort(results.begin(), results.end());
+        CHECK(results == BruteQuery(items, query));
+    }
+
+    for (int i = 0; i < 50; ++i)
+    {
+        const Vector2 origin = {RandomFloat(0, 1000), RandomFloat(0, 1000)};
+        const float angle = RandomFloat(0, 6.2831853f);
+        const Vector2 direction = {cosf(angle) * 3, sinf(angle) * 3};
+        const uint32_t ignore = (uint32_t)(rand() % items.size());
+
+        // Normalized the way Raycast does it
+        const float length = sqrtf(direction.x * direction.x + direction.y * direction.y);
+        const Vector2 dir = {direction.x / length, direction.y / length};
+        float expected = FLT_MAX;
+        for (uint32_t j = 0; j < items.size(); ++j)
+        {
+            if (items[j].proxy != AABBTree::NULL_NODE && j != ignore)
+                expected = std::min(expected, RayDistance(items[j].box, origin, dir, 400));
+        }
+
+        TreeRayHit hit;
+        const bool found = tree.Raycast(origin, direction, 400, hit, ignore);
+        CHECK(found == (expected != FLT_MAX));
+        if (found)
+        {
+            CHECK(hit.distance == expected);
+            CHECK(hit.userData != ignore && items[hit.userData].proxy != AABBTree::NULL_NODE);
+            CHECK(RayDistance(items[hit.userData].box, origin, dir, 400) == expected);
+        }
+    }
+
+    for (int i = 0; i < 50; ++i)
+    {
+        const Vector2 point = {RandomFloat(0, 1000), RandomFloat(0, 1000)};
+        float expected = FLT_MAX;
+        for (const Item& item : items)
+        {
+            if (item.proxy != AABBTree::NULL_NODE)
+                expected = std::min(expected, DistanceSquared(item.box, point));
+        }
+
+        uint32_t nearest = 0;
+        const bool found = tree.QueryNearest(point, 60, nearest);
+        CHECK(found == (expected <= 60 * 60));
+        if (found)
+            CHECK(DistanceSquared(items[nearest].box, point) == expected);
+    }
+}
+
+int main()
+{
+    srand(99);
+    AABBTree tree;
+    std::vector<Item> items(500);
+    for (uint32_t i = 0; i < items.size(); ++i)
+    {
+        items[i].box = RandomBox();
+        items[i].proxy = tree.CreateProxy(items[i].box, i);
+    }
+    CHECK(tree.GetProxyCount() == 500);
+    CheckQueries(tree, items);
+
+    for (int round = 0; round < 20; ++round)
+    {
+        int live = 0;
+        for (uint32_t i = 0; i < items.size(); ++i)
+        {
+            Item& item = items[i];
+            const int action = rand() % 20;
+            if (item.proxy == AABBTree::NULL_NODE)
+            {
+                // Removed ones come back somewhere else now and then
+                if (action == 0)
+                {
+                    item.box = RandomBox();
+                    item.proxy = tree.CreateProxy(item.box, i);
+                }
+            }
+            else if (action == 0)
+            {
+                tree.DestroyProxy(item.proxy);
+                item.proxy = AABBTree::NULL_NODE;
+            }
+            else
+            {
+                // Mostly small moves that stay in the fat box, some teleports
+                const Vector2 move = action == 1 ? Vector2{RandomFloat(-500, 500), RandomFloat(-500, 500)}
+                                                 : Vector2{RandomFloat(-3, 3), RandomFloat(-3, 3)};
+                item.box.x += move.x;
+                item.box.y += move.y;
+                tree.MoveProxy(item.proxy, item.box, move);
+            }
+            if (item.proxy != AABBTree::NULL_NODE)
+                ++live;
+        }
+
+        CHECK(tree.GetProxyCount() == live);
+        // Rotations keep it balanced, within 2 * log2(n)
+        CHECK(tree.GetHeight() <= 2 * (int)ceilf(log2f((float)live)));
+        CheckQueries(tree, items);
+    }
+
+    tree.Clear();
+    CHECK(tree.GetProxyCount() == 0);
+    std::vector<uint32_t> results;
+    tree.QueryBox({0, 0, 1000, 1000}, results);
+    CHECK(results.empty());
+
+    return TestResult("aabbtree_test");
+}
@@ -0,0 +1,138 @@
+// SweepAndPrune keeps proxies between ticks, SpatialHashGrid rebuilds every
+// tick. Both have to report the same pairs, including right after a pool
+// slot was handed to a new entity
+#include <algorithm>
+#include <vector>
+#include "broadphase.h"
+#include "entitystore.h"
+#include "check.h"
+
+static bool BoundsOverlap(const EntityStore& store, uint32_t a, uint32_t b)
+{
+    const Vector3& pa = store.positions[a];
+    const Vector3& pb = store.positions[b];
+    const Vector3& sa = store.sizes[a];
+    const Vector3& sb = store.sizes[b];
+    return pa.x < pb.x + sb.x && pb.x < pa.x + sa.x && pa.y < pb.y + sb.y && pb.y < pa.y + sa.y;
+}
+
+// Overlapping pairs as sorted handle slots. The grid also reports boxes
+// that only share a cell, those are left out
+static std::vector<std::pair<uint32_t, uint32_t>> PairsOf(const EntityStore& store, const Broadphase& broadphase)
+{
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    for (const CollisionPair& pair : broadphase.GetPairs())
+    {
+        if (!BoundsOverlap(store, pair.a, pair.b))
+            continue;
+        uint32_t a = store.ids[pair.a].index;
+        uint32_t b = store.ids[pair.b].index;
+        result.push_back({std::min(a, b), std::max(a, b)});
+    }
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+static void Step(EntityStore& store, SpatialHashGrid& grid, SweepAndPrune& sap)
+{
+    store.Flush();
+    store.SavePreviousPositions();
+    grid.Update(store);
+    sap.Update(store);
+}
+
+static void TestSlotReuse()
+{
+    EntityStore store;
+    SpatialHashGrid grid;
+    SweepAndPrune sap;
+    const uint8_t pool = store.CreatePool(1);
+
+    // A target, and a bullet in a one-slot pool well away from it
+    store.Spawn({{100, 100, 0}, {20, 20, 1}});
+    EntityId bullet = store.Spawn({{500, 500, 0}, {5, 5, 1}, WHITE, {0, 0, 0}, 1, 1, 0, pool});
+    Step(store, grid, sap);
+    CHECK(PairsOf(store, grid).empty());
+    CHECK(PairsOf(store, sap).empty());
+
+    // Respawned into the same slot, on top of the target, between ticks
+    CHECK(store.Destroy(bullet));
+    store.Flush();
+    EntityId respawned = store.Spawn({{105, 105, 0}, {5, 5, 1}, WHITE, {0, 0, 0}, 1, 1, 0, pool});
+    CHECK(respawned.index == bullet.index && respawned != bullet);
+    Step(store, grid, sap);
+
+    CHECK(PairsOf(store, grid).size() == 1);
+    CHECK(PairsOf(store, sap) == PairsOf(store, grid));
+    CHECK(sap.GetAddedPairs().size() == 1);
+
+    // Reused again while overlapping: the old pair goes, the new one comes
+    CHECK(store.Destroy(respawned));
+    store.Flush();
+    EntityId again = store.Spawn({{110, 110, 0}, {5, 5, 1}, WHITE, {0, 0, 0}, 1, 1, 0, pool});
+    Step(store, grid, sap);
+
+    CHECK(PairsOf(store, sap) == PairsOf(store, grid));
+    CHECK(sap.GetRemovedPairs().size() == 1 && (sap.GetRemovedPairs()[0].a == respawned || sap.GetRemovedPairs()[0].b == respawned));
+    CHECK(sap.GetAddedPairs().size() == 1 && (sap.GetAddedPairs()[0].a == again || sap.GetAddedPairs()[0].b == again));
+}
+
+static void TestMatchesGrid()
+{
+    EntityStore store;
+    SpatialHashGrid grid;
+    SweepAndPrune sap;
+    const uint8_t pool = store.CreatePool(32);
+
+    uint32_t random = 12345;
+    auto next = [&random](uint32_t range)
+    {
+        random = random * 1664525u + 1013904223u;
+        return (random >> 8) % range;
+    };
+
+    std::vector<EntityId> live;
+    for (int tick = 0; tick < 200; ++tick)
+    {
+        // Churn the pool so slots keep getting reused
+        if (!live.empty() && next(2) == 0)
+        {
+            const uint32_t victim = next((uint32_t)live.size());
+            store.Destroy(live[victim]);
+            live.erase(live.begin() + victim);
+            store.Flush();
+        }
+        while (store.FreeInPool(pool) > 0 && next(3) != 0)
+            live.push_back(store.Spawn({{(float)next(300), (float)next(300), 0}, {(float)(5 + next(40)), (float)(5 + next(40)), 1}, WHITE, {0, 0, 0}, 1, 1, 0, pool}));
+
+        Step(store, grid, sap);
+        CHECK(PairsOf(store, sap) == PairsOf(store, grid));
+    }
+}
+
+static void TestOversized()
+{
+    EntityStore store;
+    SpatialHashGrid grid(64);
+    SweepAndPrune sap;
+
+    // Far more than MAX_CELLS_PER_AXIS cells across, with small bodies in
+    // its far corner and outside it, and a second one overlapping it
+    store.Spawn({{0, 0, 0}, {4000, 4000, 1}});
+    store.Spawn({{3900, 3900, 0}, {20, 20, 1}});
+    store.Spawn({{5000, 100, 0}, {20, 20, 1}});
+    store.Spawn({{3000, 3000, 0}, {3000, 50, 1}});
+    Step(store, grid, sap);
+
+    CHECK(PairsOf(store, grid).size() == 2);
+    CHECK(PairsOf(store, sap) == PairsOf(store, grid));
+}
+
+int main()
+{
+    TestSlotReuse();
+    TestMatchesGrid();
+    TestOversized();
+
+    return TestResult("broadphase_test");
+}
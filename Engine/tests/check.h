@@ -0,0 +1,22 @@
+#pragma once
+#include <cstdio>
+
+// Shared by the tests, each of which is its own executable (see test.bat).
+// CHECK reports and counts a failed condition without stopping the test,
+// main returns TestResult so test.bat sees the failure.
+inline int failures = 0;
+
+#define CHECK(condition) \
+    do { if (!(condition)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); ++failures; } } while (0)
+
+// Print the summary line, returns the exit code for main
+inline int TestResult(const char* name)
+{
+    if (failures > 0)
+    {
+        printf("%s: %d checks failed\n", name, failures);
+        return 1;
+    }
+    printf("%s: passed\n", name);
+    return 0;
+}
@@ -0,0 +1,133 @@
+// The contact solver stops bodies from closing in without adding momentum,
+// bounces fast impacts, leaves immovable bodies alone and gives the same
+// bits on any number of threads
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include "contacts.h"
+#include "jobsystem.h"
+#include "check.h"
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) < 0.01f;
+}
+
+// Two 10 x 10 boxes, b overlapping a's right side by 1
+static void MakePair(EntityStore& store, float velocityA, float velocityB, float massB, float restitution)
+{
+    store.Clear();
+    store.Spawn({{0, 0, 0}, {10, 10, 1}, WHITE, {velocityA, 0, 0}, 1, 1, restitution});
+    store.Spawn({{9, 0, 0}, {10, 10, 1}, WHITE, {velocityB, 0, 0}, 1, massB, restitution});
+    store.Flush();
+    store.SavePreviousPositions();
+}
+
+static void TestInelastic()
+{
+    EntityStore store;
+    ContactManager contacts;
+    MakePair(store, 50, -50, 1, 0);
+    contacts.Update(store, {{0, 1}});
+
+    CHECK(contacts.GetContactCount() == 1);
+    CHECK(store.velocities[1].x - store.velocities[0].x >= -0.001f); // no longer closing
+    CHECK(Near(store.velocities[0].x + store.velocities[1].x, 0)); // momentum kept
+    CHECK(store.velocities[0].y == 0 && store.velocities[1].y == 0);
+    CHECK(store.positions[1].x - store.positions[0].x > 9); // pushed apart
+}
+
+static void TestBounce()
+{
+    EntityStore store;
+    ContactManager contacts;
+    MakePair(store, 50, -50, 1, 1);
+    contacts.Update(store, {{0, 1}});
+
+    CHECK(Near(store.velocities[0].x, -50) && Near(store.velocities[1].x, 50));
+}
+
+static void TestImmovable()
+{
+    EntityStore store;
+    ContactManager contacts;
+    MakePair(store, 50, 0, 0, 0);
+    contacts.Update(store, {{0, 1}});
+
+    CHECK(Near(store.velocities[0].x, 0));
+    CHECK(store.positions[1].x == 9 && store.velocities[1].x == 0);
+    CHECK(store.positions[0].x < 0); // all of the correction on a
+
+    // Moving apart already: nothing to do
+    MakePair(store, -5, 5, 1, 0);
+    contacts.Update(store, {{0, 1}});
+    CHECK(store.velocities[0].x == -5 && store.velocities[1].x == 5);
+}
+
+// 60 x 60 boxes, each overlapping its right and lower neighbour, with
+// velocities from a fixed pattern
+static void MakeGrid(EntityStore& store, std::vector<CollisionPair>& pairs)
+{
+    const int side = 60;
+    for (int y = 0; y < side; ++y)
+    {
+        for (int x = 0; x < side; ++x)
+        {
+            const float vx = (float)((x * 7 + y * 13) % 11) - 5.0f;
+            const float vy = (float)((x * 5 + y * 3) % 9) - 4.0f;
+            store.Spawn({{x * 9.5f, y * 9.5f, 0}, {10, 10, 1}, WHITE, {vx * 10, vy * 10, 0}, 1, 1.0f + (x % 3), 0.5f});
+        }
+    }
+    store.Flush();
+    store.SavePreviousPositions();
+
+    for (uint32_t y = 0; y < side; ++y)
+    {
+        for (uint32_t x = 0; x < side; ++x)
+        {
+            const uint32_t row = y * side + x;
+            if (x + 1 < side)
+                pairs.push_back({row, row + 1});
+            if (y + 1 < side)
+                pairs.push_back({row, row + side});
+        }
+    }
+}
+
+static void Solve(EntityStore& store, size_t& colors)
+{
+    std::vector<CollisionPair> pairs;
+    MakeGrid(store, pairs);
+    ContactManager contacts;
+    contacts.SetDeterministic(true);
+    for (int step = 0; step < 3; ++step)
+        contacts.Update(store, pairs);
+    colors = contacts.GetColorCount();
+}
+
+static void TestThreadCount()
+{
+    EntityStore single;
+    size_t singleColors = 0;
+    Solve(single, singleColors);
+
+    JobSystem::Init(3);
+    EntityStore threaded;
+    size_t threadedColors = 0;
+    Solve(threaded, threadedColors);
+    JobSystem::Shutdown();
+
+    CHECK(singleColors > 1 && singleColors == threadedColors);
+    CHECK(memcmp(single.positions.data(), threaded.positions.data(), single.positions.size() * sizeof(Vector3)) == 0);
+    CHECK(memcmp(single.velocities.data(), threaded.velocities.data(), single.velocities.size() * sizeof(Vector3)) == 0);
+}
+
+int main()
+{
+    TestInelastic();
+    TestBounce();
+    TestImmovable();
+    TestThreadCount();
+
+    return TestResult("contacts_test");
+}
@@ -0,0 +1,106 @@
+// With simulation.deterministic set, the same scenario has to end in the
+// same state hash every run and whichever integration path the CPU picks
+#include <cstdint>
+#include "game.h"
+#include "integrator.h"
+#include "jobsystem.h"
+#include "strictmath.h"
+#include "check.h"
+
+static const uint32_t TICKS = 600;
+
+// Small LCG so the scenario doesn't depend on the C runtime's rand
+static float Random(uint32_t& state, float min, float max)
+{
+    state = state * 1664525u + 1013904223u;
+    return min + (max - min) * (float)(state >> 8) / (float)(1u << 24);
+}
+
+// Boxes bouncing around a walled room while a system keeps spawning bullets
+// into a pool and removing the oldest boxes. nudge moves the last box,
+// which is never removed, slightly
+static uint64_t RunScenario(Integrator::Path path, const char* broadphase, float nudge = 0.0f)
+{
+    Settings settings;
+    settings.video.headless = true;
+    settings.simulation.deterministic = true;
+    settings.simulation.broadphase = broadphase;
+    Game game(settings);
+    // The constructor pins the scalar path, force the one under test
+    Integrator::SetPath(path);
+
+    TileMap& map = game.GetTileMap();
+    map.Resize(40, 30);
+    map.SetTileSize(20);
+    for (int x = 0; x < 40; ++x)
+    {
+        map.SetTile(x, 0, TILE_WALL);
+        map.SetTile(x, 29, TILE_WALL);
+    }
+    for (int y = 0; y < 30; ++y)
+    {
+        map.SetTile(0, y, TILE_WALL);
+        map.SetTile(39, y, TILE_WALL);
+    }
+    map.SetTile(20, 15, TILE_WALL);
+
+    uint32_t state = 12345;
+    std::vector<EntityId> boxes;
+    for (int i = 0; i < 200; ++i)
+    {
+        EntityDesc desc;
+        desc.position = {Random(state, 40, 740), Random(state, 40, 540), 0};
+        desc.size = {Random(state, 4, 16), Random(state, 4, 16), 1};
+        desc.velocity = {Random(state, -200, 200), Random(state, -200, 200), 0};
+        desc.friction = Random(state, 0.95f, 1.0f);
+        desc.mass = Random(state, 0.5f, 2.0f);
+        desc.restitution = Random(state, 0.0f, 0.8f);
+        if (i == 199)
+            desc.position.x += nudge;
+        boxes.push_back(game.SpawnEntity(desc));
+    }
+    game.SpawnEntity({{300, 200, 0}, {100, 100, 1}, BLANK, {0, 0, 0}, 1, 0, 0, 0, 0, ENTITY_STATIC | ENTITY_TRIGGER});
+
+    const uint8_t bullets = game.CreateEntityPool(16);
+    uint32_t tick = 0;
+    size_t oldest = 0;
+    game.RegisterSystem("Bullets", COMPONENT_NONE, COMPONENT_NONE, [&](float)
+    {
+        const float angle = tick * 0.37f;
+        game.SpawnEntity({{400, 300, 0}, {3, 3, 1}, YELLOW, {600 * StrictMath::Sin(angle), 600 * StrictMath::Sin(angle + 1.5707964f), 0},
+                          1, 1, 0, bullets, 0, ENTITY_BULLET});
+    });
+    game.RegisterSystem("Cull", COMPONENT_ENTITIES, COMPONENT_ENTITIES, [&](float)
+    {
+        if (++tick % 10 == 0 && oldest < boxes.size())
+            game.RemoveEntity(boxes[oldest++]);
+    });
+
+    for (uint32_t i = 0; i < TICKS; ++i)
+        game.Update(1.0f / 60.0f);
+    return game.GetStateHash();
+}
+
+int main()
+{
+    // Workers on, so parallel systems and solver batches are exercised
+    JobSystem::Init(3);
+
+    const uint64_t reference = RunScenario(Integrator::Path::Scalar, "grid");
+    CHECK(reference != 0);
+    CHECK(RunScenario(Integrator::Path::Scalar, "grid") == reference);
+
+    const Integrator::Path best = Integrator::DetectPath();
+    if (best >= Integrator::Path::SSE2)
+        CHECK(RunScenario(Integrator::Path::SSE2, "grid") == reference);
+    if (best >= Integrator::Path::AVX2)
+        CHECK(RunScenario(Integrator::Path::AVX2, "grid") == reference);
+
+    CHECK(RunScenario(Integrator::Path::Scalar, "sap") == RunScenario(Integrator::Path::Scalar, "sap"));
+
+    // The hash has to notice a different outcome
+    CHECK(RunScenario(Integrator::Path::Scalar, "grid", 0.25f) != reference);
+
+    JobSystem::Shutdown();
+    return TestResult("determinism_test");
+}
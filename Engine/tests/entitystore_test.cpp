@@ -0,0 +1,92 @@
+// Handles have to stay honest: made-up handles for slots that are free,
+// or whose row is waiting to be compacted away, are not alive and can't be
+// destroyed, so a pool slot is never handed out twice
+#include "entitystore.h"
+#include "check.h"
+
+static EntityId MakeHandle(uint32_t index, uint32_t generation)
+{
+    EntityId id;
+    id.index = index;
+    id.generation = generation;
+    return id;
+}
+
+static void TestFreePoolSlots()
+{
+    EntityStore store;
+    const uint8_t pool = store.CreatePool(2);
+    EntityDesc desc;
+    desc.pool = pool;
+
+    // Never spawned: both slots are free with generation 0
+    const EntityId first = store.Spawn(desc);
+    const EntityId forged = MakeHandle(first.index == 0 ? 1 : 0, 0);
+    CHECK(!store.IsAlive(forged));
+    CHECK(!store.Destroy(forged));
+    CHECK(store.FreeInPool(pool) == 1);
+
+    const EntityId second = store.Spawn(desc);
+    CHECK(second != EntityId() && second.index != first.index);
+    CHECK(store.Spawn(desc) == EntityId()); // full
+
+    // Freed again: the generation a made-up handle would guess is free too
+    store.Flush();
+    CHECK(store.Destroy(first));
+    store.Flush();
+    const EntityId guess = MakeHandle(first.index, first.generation + 1);
+    CHECK(!store.IsAlive(guess));
+    CHECK(store.IndexOf(guess) == EntityStore::INVALID_INDEX);
+    CHECK(!store.Destroy(guess));
+    CHECK(store.FreeInPool(pool) == 1);
+
+    const EntityId third = store.Spawn(desc);
+    CHECK(third.index == first.index && third.generation == guess.generation);
+    CHECK(store.Spawn(desc) == EntityId());
+}
+
+static void TestDestroyedBeforeFlush()
+{
+    EntityStore store;
+    const EntityId id = store.Spawn({});
+    store.Flush();
+    CHECK(store.IsAlive(id) && store.IndexOf(id) == 0);
+
+    CHECK(store.Destroy(id));
+    CHECK(!store.IsAlive(id));
+    const EntityId guess = MakeHandle(id.index, id.generation + 1);
+    CHECK(!store.IsAlive(guess));
+    CHECK(store.IndexOf(guess) == EntityStore::INVALID_INDEX);
+    store.Flush();
+    CHECK(store.Count() == 0);
+
+    // The slot comes back once, with the generation the guess had
+    const EntityId reused = store.Spawn({});
+    CHECK(reused.index == id.index && reused.generation == guess.generation);
+    CHECK(store.IsAlive(reused) && store.IndexOf(reused) == EntityStore::INVALID_INDEX); // pending
+    store.Flush();
+    CHECK(store.IndexOf(reused) == 0);
+    CHECK(store.Spawn({}).index != reused.index);
+}
+
+static void TestPoolLimit()
+{
+    EntityStore store;
+    for (size_t i = 1; i < EntityStore::MAX_POOLS; ++i)
+        CHECK(store.CreatePool(1) == i);
+    CHECK(store.CreatePool(1) == EntityStore::INVALID_POOL);
+
+    EntityDesc desc;
+    desc.pool = EntityStore::INVALID_POOL;
+    CHECK(store.Spawn(desc) == EntityId());
+    CHECK(store.FreeInPool(EntityStore::INVALID_POOL) == 0);
+}
+
+int main()
+{
+    TestFreePoolSlots();
+    TestDestroyedBeforeFlush();
+    TestPoolLimit();
+
+    return TestResult("entitystore_test");
+}
@@ -0,0 +1,58 @@
+// Every integration path has to produce the same bits as the scalar kernel,
+// including the tail that doesn't fill a whole SIMD register
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "integrator.h"
+#include "check.h"
+
+static float RandomFloat(float min, float max)
+{
+    return min + (max - min) * (float)rand() / (float)RAND_MAX;
+}
+
+using Kernel = void (*)(float*, float*, const float*, size_t, float);
+
+// Runs kernel on a copy of the inputs and compares against the scalar
+// kernel on another copy, a few steps in a row
+static bool MatchesScalar(Kernel kernel, size_t count)
+{
+    std::vector<float> positions(count * 3);
+    std::vector<float> velocities(count * 3);
+    std::vector<float> damping(count);
+    for (float& value : positions)
+        value = RandomFloat(-1000.0f, 1000.0f);
+    for (float& value : velocities)
+        value = RandomFloat(-300.0f, 300.0f);
+    for (float& value : damping)
+        value = RandomFloat(0.9f, 1.0f);
+
+    std::vector<float> expectedPositions = positions;
+    std::vector<float> expectedVelocities = velocities;
+    for (int step = 0; step < 4; ++step)
+    {
+        Integrator::IntegrateScalar(expectedPositions.data(), expectedVelocities.data(), damping.data(), count, 1.0f / 60.0f);
+        kernel(positions.data(), velocities.data(), damping.data(), count, 1.0f / 60.0f);
+    }
+
+    return memcmp(positions.data(), expectedPositions.data(), positions.size() * sizeof(float)) == 0
+        && memcmp(velocities.data(), expectedVelocities.data(), velocities.size() * sizeof(float)) == 0;
+}
+
+int main()
+{
+    srand(1234);
+    const Integrator::Path best = Integrator::DetectPath();
+    const size_t counts[] = {0, 1, 3, 5, 7, 8, 9, 15, 17, 33, 101, 1001};
+
+    for (size_t count : counts)
+    {
+        if (best >= Integrator::Path::SSE2)
+            CHECK(MatchesScalar(&Integrator::IntegrateSSE2, count));
+        if (best >= Integrator::Path::AVX2)
+            CHECK(MatchesScalar(&Integrator::IntegrateAVX2, count));
+        CHECK(MatchesScalar(&Integrator::IntegrateBatch, count));
+    }
+
+    return TestResult("integrator_test");
+}
@@ -0,0 +1,92 @@
+// Touching bodies sleep and wake as one island, static bodies don't join
+// islands, and a sleep time of 0 keeps everything awake
+#include <vector>
+#include "islands.h"
+#include "check.h"
+
+static const float DT = 1.0f / 60.0f;
+
+// Rows 0 and 1 touch each other, row 2 is alone, row 3 is a static floor
+// under rows 1 and 2
+static void MakeScene(EntityStore& store, std::vector<CollisionPair>& contacts)
+{
+    store.Spawn({{0, 0, 0}, {10, 10, 1}});
+    store.Spawn({{10, 0, 0}, {10, 10, 1}});
+    store.Spawn({{40, 0, 0}, {10, 10, 1}});
+    store.Spawn({{0, 10, 0}, {100, 10, 1}, WHITE, {0, 0, 0}, 1, 0, 0, 0, 0, ENTITY_STATIC});
+    store.Flush();
+    contacts = {{0, 1}, {1, 3}, {2, 3}};
+}
+
+static void Run(IslandManager& islands, EntityStore& store, const std::vector<CollisionPair>& contacts, float seconds)
+{
+    for (float time = 0; time < seconds; time += DT)
+        islands.Update(store, contacts, DT);
+}
+
+static void TestIslands()
+{
+    EntityStore store;
+    std::vector<CollisionPair> contacts;
+    MakeScene(store, contacts);
+    IslandManager islands;
+    islands.Update(store, contacts, DT);
+
+    // {0, 1} and {2}, the floor links nothing and is in no island
+    CHECK(islands.GetIslandCount() == 2);
+    CHECK(islands.GetOffsets() == std::vector<uint32_t>({0, 2, 3}));
+    CHECK(islands.GetBodies() == std::vector<uint32_t>({0, 1, 2}));
+}
+
+static void TestSleepAndWake()
+{
+    EntityStore store;
+    std::vector<CollisionPair> contacts;
+    MakeScene(store, contacts);
+    IslandManager islands;
+    islands.SetSleepTime(0.5f);
+
+    // Row 1 still drifts, so its island stays awake while row 2 sleeps
+    store.velocities[1] = {5, 0, 0};
+    Run(islands, store, contacts, 0.6f);
+    CHECK(!store.sleeping[0] && !store.sleeping[1]);
+    CHECK(store.sleeping[2]);
+
+    store.velocities[1] = {0, 0, 0};
+    Run(islands, store, contacts, 0.6f);
+    CHECK(store.sleeping[0] && store.sleeping[1]);
+
+    // Waking one body wakes its whole island, not the other one
+    store.Wake(0);
+    store.velocities[0] = {5, 0, 0};
+    islands.Update(store, contacts, DT);
+    CHECK(!store.sleeping[0] && !store.sleeping[1]);
+    CHECK(store.sleeping[2]);
+
+    // Something awake touching a sleeping body wakes it
+    contacts.push_back({0, 2});
+    islands.Update(store, contacts, DT);
+    CHECK(!store.sleeping[2]);
+    CHECK(islands.GetIslandCount() == 1);
+}
+
+static void TestNeverSleep()
+{
+    EntityStore store;
+    std::vector<CollisionPair> contacts;
+    MakeScene(store, contacts);
+    IslandManager islands;
+    islands.SetSleepTime(0.0f);
+
+    Run(islands, store, contacts, 2.0f);
+    CHECK(!store.sleeping[0] && !store.sleeping[1] && !store.sleeping[2]);
+}
+
+int main()
+{
+    TestIslands();
+    TestSleepAndWake();
+    TestNeverSleep();
+
+    return TestResult("islands_test");
+}
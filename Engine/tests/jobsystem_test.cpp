@@ -0,0 +1,110 @@
+// Jobs run exactly once, dependent jobs only after what they wait on, and
+// jobs may wait on jobs of their own
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "jobsystem.h"
+#include "check.h"
+
+// Every index of [0, count) visited exactly once
+static bool CoversOnce(size_t count, size_t minChunk)
+{
+    std::vector<int> visits(count, 0);
+    JobSystem::ParallelFor(count, minChunk, [&](size_t begin, size_t end)
+    {
+        for (size_t i = begin; i < end; ++i)
+            ++visits[i];
+    });
+
+    for (int value : visits)
+    {
+        if (value != 1)
+            return false;
+    }
+    return true;
+}
+
+struct DependencyState
+{
+    std::atomic<int> finished{0};
+    std::atomic<int> seenByLater{-1};
+};
+
+static void SlowJob(void* data, size_t, size_t)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    ((DependencyState*)data)->finished++;
+}
+
+static void LaterJob(void* data, size_t, size_t)
+{
+    DependencyState* state = (DependencyState*)data;
+    state->seenByLater = state->finished.load();
+}
+
+static void TestDependency()
+{
+    DependencyState state;
+    JobCounter first;
+    for (int i = 0; i < 8; ++i)
+    {
+        Job job;
+        job.function = &SlowJob;
+        job.data = &state;
+        job.counter = &first;
+        JobSystem::Run(job);
+    }
+
+    JobCounter second;
+    Job later;
+    later.function = &LaterJob;
+    later.data = &state;
+    later.counter = &second;
+    JobSystem::Run(later, &first);
+
+    JobSystem::Wait(second);
+    CHECK(first.IsDone());
+    CHECK(state.seenByLater == 8);
+}
+
+// Each outer chunk runs a ParallelFor of its own and waits on it from
+// inside a job
+static void TestNested()
+{
+    std::vector<std::atomic<int>> sums(64);
+    JobSystem::ParallelFor(sums.size(), 1, [&](size_t begin, size_t end)
+    {
+        for (size_t outer = begin; outer < end; ++outer)
+        {
+            JobSystem::ParallelFor(1000, 50, [&](size_t innerBegin, size_t innerEnd)
+            {
+                sums[outer] += (int)(innerEnd - innerBegin);
+            });
+        }
+    });
+
+    bool allDone = true;
+    for (const std::atomic<int>& sum : sums)
+        allDone = allDone && sum == 1000;
+    CHECK(allDone);
+}
+
+int main()
+{
+    // Without workers everything runs inline
+    CHECK(CoversOnce(1000, 16));
+
+    JobSystem::Init(3);
+    CHECK(JobSystem::GetWorkerCount() == 3);
+
+    CHECK(CoversOnce(0, 16));
+    CHECK(CoversOnce(1, 16));
+    CHECK(CoversOnce(100003, 64));
+    CHECK(CoversOnce(100003, 1));
+    TestDependency();
+    TestNested();
+
+    JobSystem::Shutdown();
+    return TestResult("jobsystem_test");
+}
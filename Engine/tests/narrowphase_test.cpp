@@ -0,0 +1,113 @@
+// Every Overlap::TestBatch path has to agree with Physics::CheckCollision,
+// including boxes that only touch, boxes of zero size and batch tails
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+#include "integrator.h"
+#include "narrowphase.h"
+#include "physics.h"
+#include "check.h"
+
+using Kernel = void (*)(const float*, const float*, const float*, const float*, uint32_t, const uint32_t*, size_t, uint8_t*);
+
+struct Boxes
+{
+    std::vector<Rectangle> rects;
+    std::vector<float> minX;
+    std::vector<float> minY;
+    std::vector<float> maxX;
+    std::vector<float> maxY;
+};
+
+// Same bounds as Narrowphase::Update builds
+static void AddBox(Boxes& boxes, Rectangle rect)
+{
+    boxes.rects.push_back(rect);
+    boxes.minX.push_back(rect.x);
+    boxes.minY.push_back(rect.y);
+    boxes.maxX.push_back(rect.x + rect.width);
+    boxes.maxY.push_back(rect.y + rect.height);
+}
+
+// On a coarse grid so edges often coincide, a quarter of the boxes have
+// zero width or height
+static Boxes MakeBoxes(size_t count)
+{
+    Boxes boxes;
+    for (size_t i = 0; i < count; ++i)
+    {
+        Rectangle rect;
+        rect.x = (float)(rand() % 20) * 0.5f;
+        rect.y = (float)(rand() % 20) * 0.5f;
+        rect.width = (float)(rand() % 8) * 0.5f;
+        rect.height = (float)(rand() % 8) * 0.5f;
+        if (rand() % 8 == 0)
+            rect.width = 0.0f;
+        if (rand() % 8 == 0)
+            rect.height = 0.0f;
+        AddBox(boxes, rect);
+    }
+    return boxes;
+}
+
+// Tests every box against count random others (repeats allowed, like
+// partners gathered from anywhere in the store)
+static bool MatchesReference(Kernel kernel, const Boxes& boxes, size_t count)
+{
+    std::vector<uint32_t> others(count);
+    std::vector<uint8_t> hits(count);
+
+    for (uint32_t box = 0; box < boxes.rects.size(); ++box)
+    {
+        for (uint32_t& other : others)
+            other = (uint32_t)(rand() % boxes.rects.size());
+
+        kernel(boxes.minX.data(), boxes.minY.data(), boxes.maxX.data(), boxes.maxY.data(),
+               box, others.data(), count, hits.data());
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (hits[i] != (uint8_t)Physics::CheckCollision(boxes.rects[box], boxes.rects[others[i]]))
+                return false;
+        }
+    }
+    return true;
+}
+
+int main()
+{
+    srand(4321);
+    const Integrator::Path best = Integrator::DetectPath();
+    const Boxes boxes = MakeBoxes(300);
+
+    // Below one register, full registers plus every possible tail
+    for (size_t count = 0; count <= 19; ++count)
+    {
+        CHECK(MatchesReference(&Overlap::TestScalar, boxes, count));
+        if (best >= Integrator::Path::SSE2)
+            CHECK(MatchesReference(&Overlap::TestSSE2, boxes, count));
+        if (best >= Integrator::Path::AVX2)
+            CHECK(MatchesReference(&Overlap::TestAVX2, boxes, count));
+    }
+
+    CHECK(MatchesReference(&Overlap::TestScalar, boxes, 299));
+    if (best >= Integrator::Path::SSE2)
+        CHECK(MatchesReference(&Overlap::TestSSE2, boxes, 299));
+    if (best >= Integrator::Path::AVX2)
+        CHECK(MatchesReference(&Overlap::TestAVX2, boxes, 299));
+
+    // Boxes sharing an edge don't overlap, a zero-size box inside does
+    // whatever CheckCollisionRecs says
+    Boxes touching;
+    AddBox(touching, {0, 0, 2, 2});
+    AddBox(touching, {2, 0, 2, 2});
+    AddBox(touching, {0, 2, 2, 2});
+    AddBox(touching, {1, 1, 0, 0});
+    const uint32_t others[3] = {1, 2, 3};
+    uint8_t hits[3] = {1, 1, 1};
+    Overlap::TestBatch(touching.minX.data(), touching.minY.data(), touching.maxX.data(), touching.maxY.data(), 0, others, 3, hits);
+    CHECK(hits[0] == 0 && hits[1] == 0);
+    CHECK(hits[2] == (uint8_t)Physics::CheckCollision(touching.rects[0], touching.rects[3]));
+
+    return TestResult("narrowphase_test");
+}
@@ -0,0 +1,95 @@
+// A headless game drawn into a RecordingRenderer: what would have been
+// drawn, in which order and with how many submissions
+#include <memory>
+#include "game.h"
+#include "check.h"
+
+static bool Same(Color a, Color b)
+{
+    return a.r == b.r && a.g == b.g && a.b == b.b && a.a == b.a;
+}
+
+static bool Same(const Rectangle& a, const Rectangle& b)
+{
+    return a.x == b.x && a.y == b.y && a.width == b.width && a.height == b.height;
+}
+
+static bool Contains(const Rectangle& outer, const Rectangle& inner)
+{
+    return inner.x >= outer.x && inner.y >= outer.y &&
+           inner.x + inner.width <= outer.x + outer.width && inner.y + inner.height <= outer.y + outer.height;
+}
+
+int main()
+{
+    Settings settings;
+    settings.video.headless = true;
+    Game game(settings);
+
+    std::unique_ptr<RecordingRenderer> recorder = std::make_unique<RecordingRenderer>(Vector2{640, 480});
+    RecordingRenderer& renderer = *recorder;
+    game.SetRenderer(std::move(recorder));
+    CHECK(game.GetViewportSize().x == 640 && game.GetViewportSize().y == 480);
+
+    // Two wall tiles that bake into one collider
+    TileMap& map = game.GetTileMap();
+    map.Resize(10, 10);
+    map.SetTileSize(20);
+    map.SetTile(1, 1, TILE_WALL);
+    map.SetTile(2, 1, TILE_WALL);
+
+    game.SpawnEntity({{100, 100, 0}, {10, 20, 1}, RED, {60, 0, 0}});
+
+    EmitterDesc emitter;
+    emitter.area = {300, 300, 50, 50};
+    emitter.maxVelocity = {10, 10};
+    emitter.minLifetime = 10;
+    emitter.maxLifetime = 10;
+    emitter.size = 2;
+    emitter.color = ORANGE;
+    ParticleSystem& particles = game.GetParticles();
+    particles.Burst(particles.AddEmitter(emitter), 25);
+
+    game.Update(1.0f / 60.0f);
+
+    renderer.BeginFrame(BLACK);
+    game.Draw(0.5f);
+    renderer.DrawText("hi", 5, 5, 10, WHITE);
+    renderer.EndFrame();
+
+    // Particles as one batch, then the wall, the entity and the text
+    const std::vector<RenderCommand>& commands = renderer.GetCommands();
+    CHECK(renderer.GetFrameCount() == 1);
+    CHECK(renderer.GetDrawCount() == 4);
+    CHECK(commands.size() == 4);
+    if (commands.size() == 4)
+    {
+        const RenderCommand& batch = commands[0];
+        CHECK(batch.type == RenderCommand::RECTANGLES);
+        CHECK(batch.rects.size() == 25 && batch.colors.size() == 25);
+        for (size_t i = 0; i < batch.rects.size(); ++i)
+        {
+            CHECK(Contains(batch.rect, batch.rects[i]));
+            CHECK(batch.rects[i].width == 2 && Same(batch.colors[i], ORANGE));
+        }
+
+        CHECK(commands[1].type == RenderCommand::RECTANGLE);
+        CHECK(Same(commands[1].rect, {20, 20, 40, 20}) && Same(commands[1].color, DARKGRAY));
+
+        // Halfway between the previous and the current tick
+        CHECK(commands[2].type == RenderCommand::RECTANGLE);
+        CHECK(Same(commands[2].rect, {100.5f, 100, 10, 20}) && Same(commands[2].color, RED));
+
+        CHECK(commands[3].type == RenderCommand::TEXT && commands[3].text == "hi");
+        CHECK(Same(commands[3].rect, {5, 5, (float)renderer.MeasureText("hi", 10), 10}));
+    }
+
+    // The last finished frame stays readable until the next one ends
+    renderer.BeginFrame(BLACK);
+    CHECK(renderer.GetCommands().size() == 4);
+    renderer.EndFrame();
+    CHECK(renderer.GetCommands().empty() && renderer.GetDrawCount() == 0);
+    CHECK(renderer.GetFrameCount() == 2);
+
+    return TestResult("renderer_test");
+}
@@ -0,0 +1,70 @@
+// Systems that conflict run in registration order in separate batches,
+// the rest share a batch, and every system runs once per Run
+#include <atomic>
+#include <vector>
+#include "jobsystem.h"
+#include "systems.h"
+#include "check.h"
+
+using Batches = std::vector<std::vector<size_t>>;
+
+static void TestBatches()
+{
+    SystemScheduler scheduler;
+    auto nothing = [](float) {};
+    scheduler.Register("Integrate", COMPONENT_POSITION, COMPONENT_VELOCITY, nothing);  // 0
+    scheduler.Register("Damp", COMPONENT_VELOCITY, COMPONENT_VELOCITY, nothing);       // 1, after 0
+    scheduler.Register("Look", COMPONENT_POSITION, COMPONENT_NONE, nothing);           // 2, reads only
+    scheduler.Register("Move", COMPONENT_NONE, COMPONENT_POSITION, nothing);           // 3, after 0 and 2
+    scheduler.Register("Score", COMPONENT_NONE, COMPONENT_USER, nothing);              // 4, own resource
+    scheduler.Register("Show", COMPONENT_USER | COMPONENT_VELOCITY, COMPONENT_NONE, nothing); // 5, after 1 and 4
+
+    CHECK(scheduler.GetBatches() == Batches({{0, 2, 4}, {1, 3}, {5}}));
+
+    // Registering again rebuilds the batches
+    scheduler.Register("Clean", COMPONENT_NONE, COMPONENT_ENTITIES, nothing);          // 6
+    scheduler.Register("Find", COMPONENT_ENTITIES, COMPONENT_NONE, nothing);           // 7, after 6
+    CHECK(scheduler.GetBatches() == Batches({{0, 2, 4, 6}, {1, 3, 7}, {5}}));
+
+    SystemScheduler empty;
+    CHECK(empty.GetBatches().empty());
+}
+
+// A later batch sees what an earlier one wrote in the same Run
+static void TestRun(bool deterministic)
+{
+    SystemScheduler scheduler;
+    scheduler.SetDeterministic(deterministic);
+
+    std::atomic<int> runs[4] = {};
+    int written = 0;
+    int seen = -1;
+    std::vector<int> order;
+    scheduler.Register("Write", COMPONENT_NONE, COMPONENT_POSITION, [&](float dt) { ++runs[0]; written = (int)(dt * 100); });
+    scheduler.Register("Other", COMPONENT_NONE, COMPONENT_USER, [&](float) { ++runs[1]; if (deterministic) order.push_back(1); });
+    scheduler.Register("Another", COMPONENT_NONE, COMPONENT_USER << 1, [&](float) { ++runs[2]; if (deterministic) order.push_back(2); });
+    scheduler.Register("Read", COMPONENT_POSITION, COMPONENT_NONE, [&](float) { ++runs[3]; seen = written; });
+
+    scheduler.Run(0.5f);
+    CHECK(seen == 50);
+    scheduler.Run(0.25f);
+    CHECK(seen == 25);
+    for (const std::atomic<int>& count : runs)
+        CHECK(count == 2);
+
+    // Deterministic runs go through a batch in registration order
+    if (deterministic)
+        CHECK(order == std::vector<int>({1, 2, 1, 2}));
+}
+
+int main()
+{
+    JobSystem::Init(3);
+
+    TestBatches();
+    TestRun(false);
+    TestRun(true);
+
+    JobSystem::Shutdown();
+    return TestResult("systems_test");
+}
@@ -0,0 +1,81 @@
+// TileMap::Collide has to get bodies out of walls they are already in,
+// not only stop the ones moving into them
+#include <cmath>
+#include "entitystore.h"
+#include "tilemap.h"
+#include "check.h"
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) < 0.01f;
+}
+
+// 10 x 10 tiles of 10 units, a 3 x 3 block of wall at tiles (3..5, 3..5)
+// and a one tile wall at (8, 1)
+static void MakeMap(TileMap& map)
+{
+    map.Resize(10, 10);
+    map.SetTileSize(10);
+    for (int y = 3; y <= 5; ++y)
+        for (int x = 3; x <= 5; ++x)
+            map.SetTile(x, y, TILE_WALL);
+    map.SetTile(8, 1, TILE_WALL);
+}
+
+// Puts a single 6 x 6 body (row 0) at position, as if it had been there
+// since the last tick, and runs Collide once
+static void CollideOnce(TileMap& map, EntityStore& store, Vector3 position, Vector3 velocity)
+{
+    store.Clear();
+    store.Spawn({position, {6, 6, 1}, WHITE, velocity});
+    store.Flush();
+    store.SavePreviousPositions();
+    map.Collide(store);
+}
+
+static void TestSpawnedInside()
+{
+    TileMap map;
+    MakeMap(map);
+    EntityStore store;
+
+    // Near the block's left edge: out to the left, the shortest way
+    const size_t row = 0;
+    CollideOnce(map, store, {32, 42, 0}, {5, 0, 0});
+    CHECK(Near(store.positions[row].x, 24) && Near(store.positions[row].y, 42));
+    CHECK(!map.Overlaps({store.positions[row].x, store.positions[row].y, 6, 6}));
+    CHECK(store.velocities[row].x == 0); // was moving back into the wall
+    CHECK(map.GetHits().size() == 1 && map.GetHits()[0].normal.x == -1);
+
+    // Dead centre of the block, 18 from every side
+    CollideOnce(map, store, {42, 42, 0}, {0, 0, 0});
+    CHECK(!map.Overlaps({store.positions[row].x, store.positions[row].y, 6, 6}));
+    CHECK(Near(fabsf(store.positions[row].x - 42) + fabsf(store.positions[row].y - 42), 18));
+}
+
+static void TestPushedIn()
+{
+    TileMap map;
+    MakeMap(map);
+    EntityStore store;
+
+    // Half into the single tile from below, as a contact might leave it
+    const size_t row = 0;
+    CollideOnce(map, store, {82, 17, 0}, {0, -3, 0});
+    CHECK(Near(store.positions[row].y, 20) && Near(store.positions[row].x, 82));
+    CHECK(store.velocities[row].y == 0);
+    CHECK(map.GetHits().size() == 1 && map.GetHits()[0].x == 8 && map.GetHits()[0].y == 1);
+
+    // Clear of every wall: left alone
+    CollideOnce(map, store, {10, 10, 0}, {3, 3, 0});
+    CHECK(Near(store.positions[row].x, 10) && Near(store.positions[row].y, 10));
+    CHECK(map.GetHits().empty());
+}
+
+int main()
+{
+    TestSpawnedInside();
+    TestPushedIn();
+
+    return TestResult("tilemap_test");
+}
@@ -0,0 +1,57 @@
+// FixedTimestep pays out banked frame time in whole ticks, never more than
+// the cap per frame, and keeps the partial tick for interpolation
+#include <cmath>
+#include "timestep.h"
+#include "check.h"
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) < 0.001f;
+}
+
+static void TestAccumulates()
+{
+    // 4 ticks per second keeps the sums exact
+    FixedTimestep timestep(4, 5);
+    CHECK(timestep.GetTickDelta() == 0.25f);
+
+    CHECK(timestep.Advance(0.125f) == 0);
+    CHECK(Near(timestep.GetAlpha(), 0.5f));
+    CHECK(timestep.Advance(0.125f) == 1);
+    CHECK(Near(timestep.GetAlpha(), 0.0f));
+    CHECK(timestep.Advance(0.625f) == 2);
+    CHECK(Near(timestep.GetAlpha(), 0.5f));
+}
+
+static void TestCap()
+{
+    FixedTimestep timestep(4, 3);
+
+    // A 2 s hitch runs 3 ticks and drops the rest of the backlog, but not
+    // the fraction of a tick that was banked
+    CHECK(timestep.Advance(2.125f) == 3);
+    CHECK(Near(timestep.GetAlpha(), 0.5f));
+    CHECK(timestep.Advance(0.125f) == 1);
+
+    // Exactly at the cap with nothing left over: nothing dropped
+    FixedTimestep exact(4, 3);
+    CHECK(exact.Advance(0.75f) == 3);
+    CHECK(Near(exact.GetAlpha(), 0.0f));
+}
+
+static void TestDefaults()
+{
+    // Nonsense settings fall back to 60 ticks per second, one per frame
+    FixedTimestep timestep(0, 0);
+    CHECK(timestep.GetTickDelta() == 1.0f / 60.0f);
+    CHECK(timestep.Advance(1.0f) == 1);
+}
+
+int main()
+{
+    TestAccumulates();
+    TestCap();
+    TestDefaults();
+
+    return TestResult("timestep_test");
+}
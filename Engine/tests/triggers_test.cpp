@@ -0,0 +1,92 @@
+// Triggers report each entity once when it enters and once when it leaves,
+// also when it only passes through during one of a tick's substeps
+#include "game.h"
+#include "check.h"
+
+static const float DT = 1.0f / 60.0f;
+
+static size_t CountEvents(const Game& game, EntityId trigger, EntityId other, TriggerEventType type)
+{
+    size_t count = 0;
+    for (const TriggerEvent& event : game.GetTriggerEvents())
+    {
+        if (event.trigger == trigger && event.other == other && event.type == type)
+            ++count;
+    }
+    return count;
+}
+
+static EntityId SpawnTrigger(Game& game)
+{
+    EntityDesc desc;
+    desc.position = {100, 100, 0};
+    desc.size = {10, 10, 1};
+    desc.mass = 0;
+    desc.flags = ENTITY_STATIC | ENTITY_TRIGGER;
+    return game.SpawnEntity(desc);
+}
+
+static void TestEnterStayExit()
+{
+    Settings settings;
+    settings.video.headless = true;
+    Game game(settings);
+    const EntityId trigger = SpawnTrigger(game);
+
+    // Drifts in at 1 unit per tick, starting 3 units left of the trigger
+    EntityDesc desc;
+    desc.position = {93, 102, 0};
+    desc.size = {4, 4, 1};
+    desc.velocity = {60, 0, 0};
+    const EntityId body = game.SpawnEntity(desc);
+
+    size_t enters = 0;
+    for (int tick = 0; tick < 10; ++tick)
+    {
+        game.Update(DT);
+        enters += CountEvents(game, trigger, body, TRIGGER_ENTER);
+        CHECK(CountEvents(game, trigger, body, TRIGGER_EXIT) == 0);
+    }
+    CHECK(enters == 1);
+    CHECK(game.IsInTrigger(trigger, body));
+
+    // Removing the body is leaving, once
+    game.RemoveEntity(body);
+    game.Update(DT);
+    CHECK(CountEvents(game, trigger, body, TRIGGER_EXIT) == 1);
+    CHECK(!game.IsInTrigger(trigger, body));
+    game.Update(DT);
+    CHECK(game.GetTriggerEvents().empty());
+}
+
+static void TestPassThroughInOneTick()
+{
+    Settings settings;
+    settings.video.headless = true;
+    Game game(settings);
+    const EntityId trigger = SpawnTrigger(game);
+
+    // 60 units in one tick: starts left of the trigger and ends right of
+    // it, only a middle substep sees the overlap
+    EntityDesc desc;
+    desc.position = {80, 102, 0};
+    desc.size = {4, 4, 1};
+    desc.velocity = {3600, 0, 0};
+    const EntityId body = game.SpawnEntity(desc);
+
+    game.Update(DT);
+    CHECK(game.GetPhysicsStats().substeps > 1);
+    CHECK(game.GetEntity(body).Position().x > 110);
+    CHECK(CountEvents(game, trigger, body, TRIGGER_ENTER) == 1);
+
+    game.Update(DT);
+    CHECK(CountEvents(game, trigger, body, TRIGGER_EXIT) == 1);
+}
+
+int main()
+{
+    TestEnterStayExit();
+    TestPassThroughInOneTick();
+
+    return TestResult("triggers_test");
+}